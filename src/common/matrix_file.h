@@ -0,0 +1,30 @@
+#ifndef __MATRIX_FILE_H
+#define __MATRIX_FILE_H
+#include <stdint.h>
+
+/*
+ * Binary distance matrix, written by ncd and read by mqtc.
+ *
+ *      offset 0        struct matrix_file_t (32 bytes)
+ *      offset 32       labels: @n NUL-terminated names, @labels bytes
+ *      offset @data    @n x @n elements, row-major, @elem bytes each
+ *
+ * Numbers are in the byte order of the machine that wrote the file.
+ * @data is a multiple of MATRIX_FILE_ALIGN, so that the elements may
+ * be used in place from a mapping of the file.
+ */
+
+#define MATRIX_FILE_MAGIC "\x93MATRIX"  /* 8 bytes, with the NUL */
+#define MATRIX_FILE_ALIGN 64
+#define MATRIX_FILE_F32   4
+#define MATRIX_FILE_F64   8
+
+struct matrix_file_t {
+        char     magic[8];
+        uint32_t n;             /* Number of rows (and columns) */
+        uint32_t elem;          /* MATRIX_FILE_F32 or MATRIX_FILE_F64 */
+        uint64_t labels;        /* Length of the labels, 0 if none */
+        uint64_t data;          /* Offset of the elements */
+};
+
+#endif
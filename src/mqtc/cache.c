@@ -0,0 +1,118 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdint.h>
+#include <inttypes.h>
+#include "cache.h"
+
+/******************************************************************************
+ * BOUNDS CACHE
+ *
+ * The quartet cost bounds depend only on the matrix, and cost O(n^4)
+ * to find, so they are kept between runs in a small text file with
+ * one line per matrix:
+ *
+ *      <hash> <n> <max> <min>
+ *
+ * The bounds are written as hex floats, so they read back exactly.
+ ******************************************************************************/
+
+#define FNV_OFFSET 0xcbf29ce484222325ULL
+#define FNV_PRIME  0x100000001b3ULL
+
+/**
+ * matrix_hash()
+ * -------------
+ * Hash the contents of a square matrix.
+ *
+ * @data : @nx@n matrix.
+ * @n    : Number of rows (and columns).
+ * Return: 64-bit FNV-1a hash of @n and the bytes of each row.
+ */
+uint64_t matrix_hash(struct ymatrix_t *data, int n)
+{
+        const unsigned char *byte;
+        uint64_t h = FNV_OFFSET;
+        size_t   k;
+        int      i;
+
+        byte = (const unsigned char *)&n;
+
+        for (k=0; k<sizeof(int); k++) {
+                h = (h ^ byte[k]) * FNV_PRIME;
+        }
+
+        for (i=0; i<n; i++) {
+                byte = (const unsigned char *)YROW(data, i);
+
+                for (k=0; k<n*sizeof(float); k++) {
+                        h = (h ^ byte[k]) * FNV_PRIME;
+                }
+        }
+
+        return h;
+}
+
+
+/**
+ * cache_load_bounds()
+ * -------------------
+ * Look up the cost bounds of a matrix in the cache file.
+ *
+ * @path : Path of the cache file.
+ * @key  : Hash of the matrix (see matrix_hash()).
+ * @n    : Size of the matrix.
+ * @max  : Filled with the maximum cost, if found.
+ * @min  : Filled with the minimum cost, if found.
+ * Return: 1 if found, else 0.
+ */
+int cache_load_bounds(const char *path, uint64_t key, int n, float *max, float *min)
+{
+        FILE    *f;
+        uint64_t k;
+        int      m;
+        float    M;
+        float    mn;
+        int      found = 0;
+
+        if ((f = fopen(path, "r")) == NULL) {
+                return 0;
+        }
+
+        while (fscanf(f, "%" SCNx64 " %d %a %a", &k, &m, &M, &mn) == 4) {
+                if (k == key && m == n) {
+                        *max  = M;
+                        *min  = mn;
+                        found = 1;
+                }
+        }
+
+        fclose(f);
+
+        return found;
+}
+
+
+/**
+ * cache_save_bounds()
+ * -------------------
+ * Record the cost bounds of a matrix in the cache file.
+ *
+ * @path : Path of the cache file.
+ * @key  : Hash of the matrix (see matrix_hash()).
+ * @n    : Size of the matrix.
+ * @max  : Maximum cost.
+ * @min  : Minimum cost.
+ * Return: Nothing.
+ */
+void cache_save_bounds(const char *path, uint64_t key, int n, float max, float min)
+{
+        FILE *f;
+
+        if ((f = fopen(path, "a")) == NULL) {
+                return;
+        }
+
+        fprintf(f, "%016" PRIx64 " %d %a %a\n", key, n, max, min);
+
+        fclose(f);
+}
@@ -0,0 +1,14 @@
+#ifndef __MQTC_CACHE
+#define __MQTC_CACHE
+
+#include <stdint.h>
+#include "tree/ytree.h"
+
+/* Sidecar file holding the cost bounds of matrices seen before */
+#define CACHE_BOUNDS_PATH "./log/bounds.cache"
+
+uint64_t matrix_hash      (struct ymatrix_t *data, int n);
+int      cache_load_bounds(const char *path, uint64_t key, int n, float *max, float *min);
+void     cache_save_bounds(const char *path, uint64_t key, int n, float max, float min);
+
+#endif
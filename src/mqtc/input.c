@@ -2,90 +2,167 @@
 #include <stdio.h>
 #include <stdbool.h>
 #include <string.h>
+#include <stdint.h>
+#include <limits.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "input.h"
+#include "../common/matrix_file.h"
 
-int read_float_line(FILE *input, float **vector, int *count)
+/******************************************************************************
+ * TEXT MATRIX
+ *
+ * One row per line, values separated by spaces or tabs. Lines may end 
+ * in "\n" or "\r\n", and blank lines are skipped, so that the leading 
+ * newline of an ncd.dat is harmless. The input is read in large blocks,
+ * and each value is converted with strtof() straight from the block, 
+ * so there is no limit on the length of a line.
+ ******************************************************************************/
+
+#define READER_BLOCK (1 << 20)
+
+struct reader_t {
+        FILE   *input;
+        char   *buf;            /* READER_BLOCK bytes, and a NUL */
+        size_t  pos;            /* Next byte to look at */
+        size_t  len;            /* Bytes held */
+        int     eof;            /* Nothing more to read */
+};
+
+
+/**
+ * reader_fill()
+ * -------------
+ * Move the unread bytes to the front of the buffer, and read more after them.
+ *
+ * @r    : Reader
+ * Return: Number of bytes added (0 at the end of the input).
+ */
+static size_t reader_fill(struct reader_t *r)
 {
-        float   data_buffer[4096];
-        char    line_buffer[4096];
+        size_t got;
+
+        if (r->eof) {
+                return 0;
+        }
 
-        char   *ptr;
-        float   datum;
-        int     status;
-        int     i = 0;
-        int     n = 0;
+        memmove(r->buf, r->buf + r->pos, r->len - r->pos);
 
-        if (NULL != fgets(line_buffer, 4096, input)) {
+        r->len -= r->pos;
+        r->pos  = 0;
 
-                ptr = line_buffer;
+        got = fread(r->buf + r->len, 1, READER_BLOCK - r->len, r->input);
+
+        if (got == 0) {
+                r->eof = 1;
+        }
+
+        r->len += got;
+        r->buf[r->len] = '\0';
+
+        return got;
+}
+
+
+/**
+ * reader_token()
+ * --------------
+ * Skip blanks, and make sure the whole next token is in the buffer.
+ *
+ * @r    : Reader
+ * Return: The first character of the token, '\n' at the end of a 
+ *         line, or EOF at the end of the input.
+ *
+ * NOTE
+ * A token is never longer than a block, so compacting the
+ * buffer always makes room to finish one.
+ */
+static int reader_token(struct reader_t *r)
+{
+        size_t end;
 
-                for (;;) {
+        for (;;) {
+                while (r->pos < r->len && (r->buf[r->pos] == ' ' || r->buf[r->pos] == '\t' || r->buf[r->pos] == '\r')) {
+                        r->pos++;
+                }
 
-                        /* Skip any leading whitespace */
-                        while ((ptr[i]==' ' || ptr[i]=='\t')) {
-                                i++;
+                if (r->pos == r->len) {
+                        if (reader_fill(r) == 0) {
+                                return EOF;
                         }
+                        continue;
+                }
+
+                if (r->buf[r->pos] == '\n') {
+                        return '\n';
+                }
 
-                        /* 
-                         * If we hit a newline, that's 
-                         * the end of the loop. 
-                         */
-                        if (ptr[i] == '\n') {
-                                break;
-                        } else {
-                                /* 
-                                 * Otherwise, we must have
-                                 * stopped in front of a
-                                 * non-whitespace character.
-                                 *
-                                 * Let's scan it.
-                                 */
-                                status = sscanf(&(ptr[i]), "%f", &datum);
-
-                                if (status == 0 || status == EOF) {
-                                        printf("Scan error.\n");
-                                        return 0;
-                                } else {
-                                        /* Add the new item to our data */ 
-                                        data_buffer[n] = datum;
-                                        n++;
-
-                                        /* 
-                                         * Scan until the end of the
-                                         * thing we just read.
-                                         */
-                                        while ((ptr[i]!=' ' && ptr[i]!='\n')) {
-                                                i++;
-                                        }
-                                }
+                /* Find where the token ends */
+                for (end=r->pos; end < r->len; end++) {
+                        if (r->buf[end] == ' ' || r->buf[end] == '\t' || r->buf[end] == '\r' || r->buf[end] == '\n') {
+                                return (unsigned char)r->buf[r->pos];
                         }
                 }
-        } else {
-                return EOF;
+
+                if (r->eof || (r->pos == 0 && r->len == READER_BLOCK) || reader_fill(r) == 0) {
+                        return (unsigned char)r->buf[r->pos];
+                }
         }
+}
 
-        /*
-         * If the user gave us a count pointer
-         * to fill in, go ahead and do that.
-         */
-        if (count != NULL) {
-                *count = n;
+
+/**
+ * read_float_line()
+ * -----------------
+ * Parse the next non-blank line of the input into an array of floats.
+ *
+ * @r     : Reader
+ * @vector: Row to fill; grown (along with @max) as needed
+ * @max   : Capacity of @vector
+ * @count : Filled with the number of values on the line
+ * Return: 1 (line read), 0 (scan error) or EOF (no more lines).
+ */
+static int read_float_line(struct reader_t *r, float **vector, int *max, int *count)
+{
+        char *end;
+        float datum;
+        int   c;
+        int   n = 0;
+
+        /* Skip blank lines */
+        while ((c = reader_token(r)) == '\n') {
+                r->pos++;
         }
 
-        /*
-         * If the user gave us a NULL pointer,
-         * allocate some memory for it and
-         * put the contents of data_buffer at
-         * that memory location.
-         */
-        if (vector != NULL) {
-                if (*vector == NULL) {
-                        *vector = calloc(1, n*sizeof(float));
+        if (c == EOF) {
+                return EOF;
+        }
+
+        while ((c = reader_token(r)) != '\n' && c != EOF) {
+
+                datum = strtof(r->buf + r->pos, &end);
+
+                if (end == r->buf + r->pos || !(*end == ' ' || *end == '\t' || *end == '\r' || *end == '\n' || *end == '\0')) {
+                        fprintf(stderr, "Scan error.\n");
+                        return 0;
                 }
-                for (i=0; i<n; i++) {
-                        (*vector)[i] = data_buffer[i];
+
+                r->pos = end - r->buf;
+
+                if (n == *max) {
+                        *max    = (*max == 0) ? 64 : 2 * (*max);
+                        *vector = realloc(*vector, (*max) * sizeof(float));
                 }
+
+                (*vector)[n++] = datum;
         }
 
+        if (c == '\n') {
+                r->pos++;
+        }
+
+        *count = n;
+
         return 1;
 }
 
@@ -98,7 +175,7 @@ int read_float_line(FILE *input, float **vector, int *count)
  *
  * @input: Input file stream
  * @count: Number of rows in the matrix
- * Return: Square matrix of floating-point values.
+ * Return: Square matrix of floating-point values, or NULL.
  *
  * NOTE
  * The method used for reading and allocating is slightly
@@ -107,46 +184,68 @@ int read_float_line(FILE *input, float **vector, int *count)
  * that to determine the number of lines, then allocate
  * them, then read it again. STDIN, for example, cannot be
  * seeked on, so functions like rewind() will not work.
+ *
+ * Instead, the width of the first row gives the number of
+ * rows, and every other row has to have just as many values.
  */
-float **read_square_matrix(FILE *input, int *count)
+struct ymatrix_t *read_square_matrix(FILE *input, int *count)
 {
-        float **matrix;
-        float  *first_line = NULL;
-        int     n = 0;
-        int     i = 0;
+        struct reader_t r;
+        struct ymatrix_t *matrix = NULL;
+        float  *line   = NULL;
+        int     max    = 0;
+        int     n      = 0;
+        int     m      = 0;
+        int     i      = 0;
+
+        r.input = input;
+        r.buf   = malloc(READER_BLOCK + 1);
+        r.pos   = 0;
+        r.len   = 0;
+        r.eof   = 0;
+
+        r.buf[0] = '\0';
 
         /*
          * Parse the first line into an array of floats.
          */
-        if (EOF == read_float_line(input, &first_line, &n)) {
+        if (1 != read_float_line(&r, &line, &max, &n) || n == 0) {
                 fprintf(stderr, "Couldn't read first line.\n");
-                return NULL;
+                goto done;
         }
                 
         /*
          * Now we know how many fields there are, we can
-         * allocate the right number of row pointers
-         * (since the matrix is square). 
+         * allocate the whole matrix (since it is square). 
          */
-        if (NULL == (matrix=calloc(n, sizeof(float *)))) {
+        if (NULL == (matrix=ymatrix_create(n))) {
                 fprintf(stderr, "Out of memory.\n");
-                return NULL;
+                goto done;
         }
 
         /* 
-         * Assign the first row (We already scanned it in)
+         * Copy in the first row (We already scanned it in)
          */
-        matrix[0] = first_line;
+        memcpy(YROW(matrix, 0), line, n * sizeof(float));
 
         /*
-         * Scan the remaining lines into the allocated
-         * matrix region.
+         * Scan the remaining lines through the same
+         * line buffer into the matrix.
          */
         for (i=1; i<n; i++) {
-                float *line = NULL;
-                if (EOF != read_float_line(input, &line, NULL)) {
-                        matrix[i] = line; 
+                if (1 != read_float_line(&r, &line, &max, &m) || m != n) {
+                        fprintf(stderr, "Row %d: expected %d values.\n", i+1, n);
+                        break;
                 }
+
+                memcpy(YROW(matrix, i), line, n * sizeof(float));
+        }
+
+        if (i < n) {
+                free(matrix->cell);
+                free(matrix);
+                matrix = NULL;
+                goto done;
         }
 
         /* Assign for the caller to have a count. */
@@ -154,5 +253,189 @@ float **read_square_matrix(FILE *input, int *count)
                 *count = n;
         }
 
+done:
+        free(line);
+        free(r.buf);
+
         return matrix;
 }
+
+
+/**
+ * read_stream()
+ * -------------
+ * Read all of a (possibly un-seekable) input stream into memory.
+ *
+ * @input: Input file stream
+ * @size : Filled with the number of bytes read
+ * Return: Buffer holding the contents of @input, or NULL.
+ */
+static unsigned char *read_stream(FILE *input, size_t *size)
+{
+        unsigned char *buf = NULL;
+        unsigned char *tmp;
+        size_t max = 0;
+        size_t len = 0;
+
+        do {
+                if (len == max) {
+                        max = (max == 0) ? (1 << 20) : 2 * max;
+
+                        if ((tmp = realloc(buf, max)) == NULL) {
+                                free(buf);
+                                return NULL;
+                        }
+                        buf = tmp;
+                }
+
+                len += fread(buf + len, 1, max - len, input);
+
+        } while (!feof(input) && !ferror(input));
+
+        *size = len;
+
+        return buf;
+}
+
+
+/**
+ * read_binary_matrix()
+ * --------------------
+ * Read a binary matrix file (see common/matrix_file.h) into memory.
+ *
+ * @input: Input file stream, at the start of the file
+ * @count: Number of rows in the matrix
+ * Return: Square matrix of floating-point values.
+ *
+ * NOTE
+ * Nothing is parsed. If @input is a regular file, it is mapped,
+ * and float32 elements are used straight from the mapping, with
+ * a stride of @n; otherwise, e.g. on a pipe, it is read into one
+ * buffer first. float64 elements are narrowed into a new matrix,
+ * since the trees work in float.
+ */
+struct ymatrix_t *read_binary_matrix(FILE *input, int *count)
+{
+        struct matrix_file_t head;
+        struct stat st;
+        struct ymatrix_t *matrix;
+        unsigned char *base;
+        double *cell;
+        size_t  size;
+        size_t  n;
+        size_t  i;
+        size_t  j;
+        int     mapped = 0;
+
+        if (fstat(fileno(input), &st) == 0 && S_ISREG(st.st_mode) && ftell(input) == 0) {
+                size = st.st_size;
+                base = mmap(NULL, size, PROT_READ|PROT_WRITE, MAP_PRIVATE, fileno(input), 0);
+
+                if (base == MAP_FAILED) {
+                        fprintf(stderr, "Couldn't map the matrix.\n");
+                        return NULL;
+                }
+                mapped = 1;
+        } else if ((base = read_stream(input, &size)) == NULL) {
+                fprintf(stderr, "Out of memory.\n");
+                return NULL;
+        }
+
+        if (size < sizeof(head)) {
+                goto bad;
+        }
+
+        memcpy(&head, base, sizeof(head));
+
+        n = head.n;
+
+        /* 
+         * Sizes come from the file, so divide rather than multiply,
+         * lest a huge @n wrap around and pass. 
+         */
+        if (memcmp(head.magic, MATRIX_FILE_MAGIC, sizeof(head.magic)) != 0
+        || (head.elem != MATRIX_FILE_F32 && head.elem != MATRIX_FILE_F64)
+        ||  n == 0
+        ||  n > INT_MAX
+        ||  head.data % sizeof(double) != 0
+        ||  head.data > size
+        ||  head.data < sizeof(head)
+        ||  head.labels > head.data - sizeof(head)
+        ||  n > (size - head.data) / head.elem / n) {
+                goto bad;
+        }
+
+        if (head.elem == MATRIX_FILE_F32) {
+                matrix = ymatrix_wrap((float *)(base + head.data), (int)n, (int)n);
+        } else {
+                matrix = ymatrix_create((int)n);
+                cell   = (double *)(base + head.data);
+
+                for (i=0; matrix!=NULL && i<n; i++) {
+                        for (j=0; j<n; j++) {
+                                YDIST(matrix, i, j) = (float)cell[i*n + j];
+                        }
+                }
+
+                if (mapped) {
+                        munmap(base, size);
+                } else {
+                        free(base);
+                }
+        }
+
+        if (matrix == NULL) {
+                fprintf(stderr, "Out of memory.\n");
+                return NULL;
+        }
+
+        /* Assign for the caller to have a count. */
+        if (count != NULL) {
+                *count = (int)n;
+        }
+
+        return matrix;
+
+bad:
+        fprintf(stderr, "Not a valid matrix file.\n");
+
+        if (mapped) {
+                munmap(base, size);
+        } else {
+                free(base);
+        }
+
+        return NULL;
+}
+
+
+/**
+ * read_matrix()
+ * -------------
+ * Read a square matrix, in either the text or the binary format.
+ *
+ * @input: Input file stream
+ * @count: Number of rows in the matrix
+ * Return: Square matrix of floating-point values.
+ *
+ * NOTE
+ * The binary format starts with a byte no text matrix can
+ * start with, so one byte of lookahead is enough to tell.
+ */
+struct ymatrix_t *read_matrix(FILE *input, int *count)
+{
+        int c;
+
+        if ((c = getc(input)) == EOF) {
+                fprintf(stderr, "Couldn't read first line.\n");
+                return NULL;
+        }
+
+        ungetc(c, input);
+
+        if (c == (unsigned char)MATRIX_FILE_MAGIC[0]) {
+                return read_binary_matrix(input, count);
+        } else {
+                return read_square_matrix(input, count);
+        }
+}
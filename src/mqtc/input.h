@@ -1,6 +1,11 @@
 #ifndef __MQTC_INPUT
 #define __MQTC_INPUT
 
-float **read_square_matrix(FILE *input, int *count);
+#include <stdio.h>
+#include "tree/ytree.h"
+
+struct ymatrix_t *read_square_matrix(FILE *input, int *count);
+struct ymatrix_t *read_binary_matrix(FILE *input, int *count);
+struct ymatrix_t *read_matrix       (FILE *input, int *count);
 
 #endif
@@ -7,6 +7,8 @@
 #include "tree/ytree.h"
 #include "logs.h"
 #include "input.h"
+#include "temper.h"
+#include "cache.h"
 
 int DATA_COUNT;
 
@@ -91,11 +93,67 @@ float *build_pmf(int limit)
         return value;
 }
 
+/**
+ * load_bounds()
+ * ------------- 
+ * Find the cost bounds of the input matrix, from the cache if possible.
+ *
+ * @data : Input matrix.
+ * @n    : Size of @data.
+ * Return: Nothing.
+ *
+ * NOTE
+ * The bounds are handed to the tree library, so that every
+ * tree created over @data uses them without recomputing.
+ */
+void load_bounds(struct ymatrix_t *data, int n)
+{
+        uint64_t key;
+        float    max;
+        float    min;
+
+        key = matrix_hash(data, n);
+
+        if (cache_load_bounds(CACHE_BOUNDS_PATH, key, n, &max, &min)) {
+                ytree_cost_bounds_set(data, n, max, min);
+        } else {
+                ytree_cost_bounds(data, n, &max, &min);
+                cache_save_bounds(CACHE_BOUNDS_PATH, key, n, max, min);
+        }
+}
+
+
+/**
+ * check_cost()
+ * ------------ 
+ * Check the cost kept up by the mutations against one computed afresh.
+ *
+ * @tree : Tree to check.
+ * Return: Nothing.
+ *
+ * NOTE
+ * The cached sums are adjusted by adding and subtracting
+ * on every mutation, so some rounding is expected; more
+ * than COST_TOLERANCE of the cost means they are wrong.
+ */
+#define COST_TOLERANCE 1e-4
+
+void check_cost(struct ytree_t *tree)
+{
+        float cached = ytree_cost(tree);
+        float actual = ytree_cost_full(tree);
+
+        if (fabsf(cached - actual) > COST_TOLERANCE * fabsf(actual)) {
+                fprintf(stderr, "[ALERT] cached cost %f, actual cost %f\n", cached, actual);
+        }
+}
+
+
 /**
  * run_mutations()
  * --------------- 
  */
-void run_mutations(int gens, FILE *input)
+void run_mutations(int gens, bool relabel, FILE *input)
 {
         #define N_TREES 3 
         struct ytree_t *tree[N_TREES];
@@ -103,7 +161,7 @@ void run_mutations(int gens, FILE *input)
         struct ytree_t *champion;
         struct alias_t *alias;
         float          *prob;
-        float         **data;
+        struct ymatrix_t *data;
         float           best_cost = 0.0;
         float           init_cost[N_TREES];
         float           this_cost[N_TREES];
@@ -116,16 +174,26 @@ void run_mutations(int gens, FILE *input)
          * phylogenetic tree from it.
          */
 
-        data = read_square_matrix(input, &DATA_COUNT);
+        data = read_matrix(input, &DATA_COUNT);
+
+        if (data == NULL) {
+                return;
+        }
+
+        load_bounds(data, DATA_COUNT);
+
+        if (relabel) {
+                ymatrix_relabel(data);
+        }
 
         /*for (i=0; i<DATA_COUNT; i++) {*/
                 /*for (j=0; j<DATA_COUNT; j++) {*/
-                        /*if (data[i][j] < 0.0) {*/
-                                /*data[i][j] = 0.0;*/
+                        /*if (YDIST(data, i, j) < 0.0) {*/
+                                /*YDIST(data, i, j) = 0.0;*/
                                 /*printf("[ALERT] '<0' datum corrected\n");*/
                         /*}*/
-                        /*if (data[i][j] > 1.0) {*/
-                                /*data[i][j] = 1.0;*/
+                        /*if (YDIST(data, i, j) > 1.0) {*/
+                                /*YDIST(data, i, j) = 1.0;*/
                                 /*printf("[ALERT] '>1' datum corrected\n");*/
                         /*}*/
                 /*}*/
@@ -199,8 +267,7 @@ void run_mutations(int gens, FILE *input)
                 }
 
                 if (best_tree != NULL) {
-                        ytree_free(champion);
-                        champion = ytree_copy(best_tree);
+                        ytree_copy_into(champion, best_tree);
                         best_tree = NULL;
                 }
 
@@ -210,6 +277,8 @@ void run_mutations(int gens, FILE *input)
                 }
         }
 
+        check_cost(champion);
+
         ynode_print(champion->root, "%d");
         printf("best:%f init:", best_cost);
         for (i=0; i<N_TREES; i++) {
@@ -219,17 +288,92 @@ void run_mutations(int gens, FILE *input)
 }
 
 
+/**
+ * run_tempering()
+ * --------------- 
+ * Search with parallel tempering across several chains and threads.
+ *
+ * @gens   : Number of generations to run each chain.
+ * @threads: Number of worker threads.
+ * @chains : Number of chains (temperatures).
+ * @relabel: Reorder the matrix for locality (see ymatrix_relabel()).
+ * @input  : Input matrix stream.
+ */
+void run_tempering(int gens, int threads, int chains, bool relabel, FILE *input)
+{
+        struct ytree_t *champion;
+        struct alias_t *alias;
+        float          *prob;
+        struct ymatrix_t *data;
+        float           best_cost;
+
+        data = read_matrix(input, &DATA_COUNT);
+
+        if (data == NULL) {
+                return;
+        }
+
+        load_bounds(data, DATA_COUNT);
+
+        if (relabel) {
+                ymatrix_relabel(data);
+        }
+
+        prob  = build_pmf(sufficient_k(DATA_COUNT));
+        alias = alias_create(sufficient_k(DATA_COUNT), prob);
+
+        champion = temper_run(data, DATA_COUNT, alias, gens, threads, chains, &best_cost);
+
+        check_cost(champion);
+
+        ynode_print(champion->root, "%d");
+        printf("best:%f chains:%d threads:%d\n", best_cost, chains, threads);
+}
+
+
 int main(int argc, char *argv[])
 {
-        if (argc == 2) {
+        int threads = 0;
+        int chains  = 0;
+        int gens    = -1;
+        bool relabel = false;
+        int i;
+
+        for (i=1; i<argc; i++) {
+                if (!strcmp(argv[i], "--threads") && i+1 < argc) {
+                        threads = atoi(argv[++i]);
+                } else if (!strcmp(argv[i], "--chains") && i+1 < argc) {
+                        chains = atoi(argv[++i]);
+                } else if (!strcmp(argv[i], "--relabel")) {
+                        relabel = true;
+                } else if (!strcmp(argv[i], "--seed") && i+1 < argc) {
+                        prng_seed(strtoull(argv[++i], NULL, 10));
+                } else if (!strcmp(argv[i], "--check=none")) {
+                        ytree_check_set(YTREE_CHECK_NONE);
+                } else if (!strcmp(argv[i], "--check=sampled")) {
+                        ytree_check_set(YTREE_CHECK_SAMPLED);
+                } else if (!strcmp(argv[i], "--check=full")) {
+                        ytree_check_set(YTREE_CHECK_FULL);
+                } else if (gens == -1) {
+                        gens = atoi(argv[i]);
+                } else {
+                        gens = -1;
+                        break;
+                }
+        }
+
+        if (gens >= 0) {
                 open_logs();
-                run_mutations(atoi(argv[1]), stdin);
+                if (threads > 0 || chains > 0) {
+                        run_tempering(gens, threads, chains, relabel, stdin);
+                } else {
+                        run_mutations(gens, relabel, stdin);
+                }
                 close_logs();
                 return 1;
         } else {
-                printf("Usage: cat <datafile> | %s <# generations>", argv[0]); 
+                printf("Usage: cat <datafile> | %s [--threads N] [--chains M] [--relabel] [--seed S] [--check=none|sampled|full] <# generations>", argv[0]); 
         }
         
         return 0;
 }
-
@@ -1,6 +1,8 @@
 #ifndef __MATH_COIN_H
 #define __MATH_COIN_H
 
+#include "prng.h"
+
 #define HEADS 0 
 #define TAILS 1
 
@@ -27,9 +29,12 @@ int coin_tails(double bias);
  * -----------
  * Flip a fair coin.
  * Return: 0 (heads) or 1 (tails).
+ *
+ * NOTE
+ * One random bit; no need to go through a double.
  */
 #define coin_fair() \
-        coin_heads(0.5)
+        prng_random_bit()
 
 
 #endif
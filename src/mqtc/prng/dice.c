@@ -1,4 +1,5 @@
 #include <stdlib.h>
+#include <stdint.h>
 #include <math.h>
 #include "prng.h"
 #include "dice.h"
@@ -14,7 +15,7 @@
  */
 int dice_roll(int sides)                                                          
 {
-        return (int)(floor(prng_uniform_random()*(double)sides))%sides;
+        return (int)prng_random_below((uint32_t)sides);
 }
 
 
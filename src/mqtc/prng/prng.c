@@ -1,13 +1,146 @@
 #include <stdlib.h>
+#include <stdint.h>
+#include <time.h>
 #include <math.h>
-#include "mersenne.h"
+#include "xoshiro.h"
 
 /*
  * Generator structure to generate random 
- * values via the Mersenne Twister 
- * algorithm.
+ * values via the xoshiro256** algorithm.
  */
-static struct mt_t Generator = {0};
+static struct xoshiro_t Generator = {{0}};
+
+/*
+ * Generator in use by the calling thread, if one 
+ * has been bound with prng_bind(), so that each 
+ * chain can draw from its own stream.
+ */
+static _Thread_local struct xoshiro_t *Bound = NULL;
+
+#define GENERATOR ((Bound != NULL) ? Bound : __prng_default())
+
+
+/**
+ * __prng_default()
+ * ````````````````
+ * The default generator, seeded from the clock if prng_seed() 
+ * was never called.
+ */
+static inline struct xoshiro_t *__prng_default(void)
+{
+        if (!xoshiro_seeded(&Generator)) {
+                xoshiro_seed(&Generator, (uint64_t)time(NULL));
+        }
+        return &Generator;
+}
+
+
+/**
+ * prng_seed()
+ * ```````````
+ * Seed the default generator, so that a run can be repeated.
+ *
+ * @seed : Seed value
+ * Return: nothing
+ */
+void prng_seed(uint64_t seed)
+{
+        xoshiro_seed(&Generator, seed);
+}
+
+
+/**
+ * prng_bind()
+ * ```````````
+ * Use a particular generator for draws made by the calling thread.
+ *
+ * @x    : Generator to use, or NULL for the default generator.
+ * Return: nothing
+ */
+void prng_bind(struct xoshiro_t *x)
+{
+        Bound = x;
+}
+
+
+/**
+ * prng_fork()
+ * ```````````
+ * Split off a new stream from the current generator.
+ *
+ * @x    : Generator to set up.
+ * Return: nothing
+ *
+ * NOTE
+ * @x takes over the current state, and the current generator
+ * jumps 2^128 draws ahead, so the two streams never overlap.
+ * Forks made in the same order from the same seed give the
+ * same streams, whatever thread later draws from them.
+ */
+void prng_fork(struct xoshiro_t *x)
+{
+        struct xoshiro_t *g = GENERATOR;
+
+        *x = *g;
+        xoshiro_jump(g);
+}
+
+
+/**
+ * prng_random_int64()
+ * ```````````````````
+ * Generate a uniform random 64-bit integer.
+ * Return: random integer
+ */
+uint64_t prng_random_int64(void)
+{
+        return xoshiro_next(GENERATOR);
+}
+
+
+/**
+ * prng_random_below()
+ * ```````````````````
+ * Generate a uniform random integer on [0,n)
+ *
+ * @n    : Upper bound (exclusive); must be at least 1.
+ * Return: random integer
+ *
+ * NOTE
+ * Uses the multiply-and-shift of [Lemire 2019] rather than 
+ * scaling a double: the high 32 bits of r*n are uniform on 
+ * [0,n) once the few low products that would bias them are 
+ * redrawn, and the division to find those is rarely needed.
+ */
+uint32_t prng_random_below(uint32_t n)
+{
+        struct xoshiro_t *g = GENERATOR;
+        uint64_t m;
+        uint32_t t;
+
+        m = (xoshiro_next(g) >> 32) * (uint64_t)n;
+
+        if ((uint32_t)m < n) {
+                t = -n % n;
+                while ((uint32_t)m < t) {
+                        m = (xoshiro_next(g) >> 32) * (uint64_t)n;
+                }
+        }
+
+        return (uint32_t)(m >> 32);
+}
+
+
+/**
+ * prng_random_bit()
+ * `````````````````
+ * Generate a uniform random bit.
+ * Return: 0 or 1
+ */
+int prng_random_bit(void)
+{
+        return (int)(xoshiro_next(GENERATOR) >> 63);
+}
 
 
 /**
@@ -18,7 +151,8 @@ static struct mt_t Generator = {0};
  */
 double prng_uniform_random(void)
 {
-        return mt_random_real_0(&Generator);
+        /* Divide by 2^53 - 1 */
+        return (xoshiro_next(GENERATOR) >> 11) * (1.0/9007199254740991.0);
 }
 
 /**
@@ -29,7 +163,8 @@ double prng_uniform_random(void)
  */
 double prng_uniform_random_open_right(void)
 {
-        return mt_random_real_1(&Generator);
+        /* Divide by 2^53 */
+        return (xoshiro_next(GENERATOR) >> 11) * (1.0/9007199254740992.0);
 }
 
 /**
@@ -40,7 +175,6 @@ double prng_uniform_random_open_right(void)
  */
 double prng_uniform_random_open(void)
 {
-        return mt_random_real_2(&Generator);
+        /* Divide by 2^52 */
+        return (((double)(xoshiro_next(GENERATOR) >> 12)) + 0.5) * (1.0/4503599627370496.0);
 }
-
-
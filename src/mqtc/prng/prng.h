@@ -1,10 +1,17 @@
 #ifndef __JDL_PRNG
 #define __JDL_PRNG
 
-#include "mersenne.h"
+#include <stdint.h>
+#include "xoshiro.h"
 
-double prng_uniform_random(void);
-double prng_uniform_random_open_right(void);
-double prng_uniform_random_open(void);
+void     prng_seed(uint64_t seed);
+void     prng_bind(struct xoshiro_t *x);
+void     prng_fork(struct xoshiro_t *x);
+uint64_t prng_random_int64(void);
+uint32_t prng_random_below(uint32_t n);
+int      prng_random_bit(void);
+double   prng_uniform_random(void);
+double   prng_uniform_random_open_right(void);
+double   prng_uniform_random_open(void);
 
 #endif
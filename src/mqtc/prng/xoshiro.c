@@ -0,0 +1,130 @@
+/******************************************************************************
+ * Implements the xoshiro256** pseudorandom number generator [Blackman 2018].
+ *
+ * The state is four 64-bit words, so a generator is cheap to copy and to
+ * keep one per chain, and each call is a handful of shifts, rotates and
+ * xors. xoshiro_jump() advances a generator by 2^128 calls, which gives
+ * any number of streams that are known not to overlap.
+ *
+ * The reference implementation by David Blackman and Sebastiano Vigna has
+ * been placed in the public domain.
+ ******************************************************************************/
+#include <stdint.h>
+#include "xoshiro.h"
+
+#define ROTL(x, k) (((x) << (k)) | ((x) >> (64 - (k))))
+
+
+/**
+ * splitmix64()
+ * ------------
+ * Step a SplitMix64 generator [Steele 2014].
+ *
+ * @z    : State of the generator, advanced.
+ * Return: Next output.
+ *
+ * NOTE
+ * Used only to spread a seed over the xoshiro state, as the
+ * authors recommend; nearby seeds give unrelated states.
+ */
+static uint64_t splitmix64(uint64_t *z)
+{
+        uint64_t r = (*z += 0x9e3779b97f4a7c15ULL);
+
+        r = (r ^ (r >> 30)) * 0xbf58476d1ce4e5b9ULL;
+        r = (r ^ (r >> 27)) * 0x94d049bb133111ebULL;
+
+        return r ^ (r >> 31);
+}
+
+
+/**
+ * xoshiro_seed()
+ * --------------
+ * Prime the generator deterministically from a single seed value.
+ *
+ * @x    : The xoshiro struct
+ * @seed : Seed value
+ * Return: nothing
+ */
+void xoshiro_seed(struct xoshiro_t *x, uint64_t seed)
+{
+        int i;
+
+        for (i=0; i<4; i++) {
+                x->s[i] = splitmix64(&seed);
+        }
+}
+
+
+/**
+ * xoshiro_seeded()
+ * ----------------
+ * Return: 1 if the generator has been seeded, else 0.
+ */
+int xoshiro_seeded(struct xoshiro_t *x)
+{
+        return (x->s[0] | x->s[1] | x->s[2] | x->s[3]) != 0;
+}
+
+
+/**
+ * xoshiro_next()
+ * --------------
+ * Generate the next pseudo-random value.
+ *
+ * @x    : The xoshiro struct
+ * Return: A pseudorandom 64-bit integer.
+ */
+uint64_t xoshiro_next(struct xoshiro_t *x)
+{
+        uint64_t *s = x->s;
+        uint64_t  r = ROTL(s[1] * 5, 7) * 9;
+        uint64_t  t = s[1] << 17;
+
+        s[2] ^= s[0];
+        s[3] ^= s[1];
+        s[1] ^= s[2];
+        s[0] ^= s[3];
+        s[2] ^= t;
+        s[3]  = ROTL(s[3], 45);
+
+        return r;
+}
+
+
+/**
+ * xoshiro_jump()
+ * --------------
+ * Advance the generator by 2^128 calls to xoshiro_next().
+ *
+ * @x    : The xoshiro struct
+ * Return: nothing
+ */
+void xoshiro_jump(struct xoshiro_t *x)
+{
+        static const uint64_t JUMP[] = {
+                0x180ec6d33cfd0abaULL, 0xd5a61266f0c9392cULL,
+                0xa9582618e03fc9aaULL, 0x39abdc4529b1661cULL
+        };
+        uint64_t s[4] = {0};
+        int i;
+        int b;
+
+        for (i=0; i<4; i++) {
+                for (b=0; b<64; b++) {
+                        if (JUMP[i] & (1ULL << b)) {
+                                s[0] ^= x->s[0];
+                                s[1] ^= x->s[1];
+                                s[2] ^= x->s[2];
+                                s[3] ^= x->s[3];
+                        }
+                        xoshiro_next(x);
+                }
+        }
+
+        x->s[0] = s[0];
+        x->s[1] = s[1];
+        x->s[2] = s[2];
+        x->s[3] = s[3];
+}
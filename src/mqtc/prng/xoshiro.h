@@ -0,0 +1,17 @@
+#ifndef __XOSHIRO_H
+#define __XOSHIRO_H
+
+#include <stdint.h>
+
+struct xoshiro_t {
+        /* State of the generator; never all zero once seeded */
+        uint64_t s[4];
+};
+
+
+void     xoshiro_seed   (struct xoshiro_t *x, uint64_t seed);
+uint64_t xoshiro_next   (struct xoshiro_t *x);
+void     xoshiro_jump   (struct xoshiro_t *x);
+int      xoshiro_seeded (struct xoshiro_t *x);
+
+#endif
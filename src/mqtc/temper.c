@@ -0,0 +1,288 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <math.h>
+#include <pthread.h>
+#include "tree/ytree.h"
+#include "logs.h"
+#include "temper.h"
+
+/******************************************************************************
+ * PARALLEL TEMPERING 
+ * ------------------
+ * Run several Markov chains at a ladder of temperatures, each on its
+ * own tree and PRNG stream, spread across worker threads. Every few
+ * generations neighbouring chains may exchange their trees, letting
+ * good states found by the hot (exploring) chains drift down to the
+ * cold (climbing) ones.
+ *
+ ******************************************************************************/
+
+/* Coldest and hottest temperatures on the ladder (in units of S(T)) */
+#define TEMPER_T_MIN 0.0005
+#define TEMPER_T_MAX 0.05
+
+/* Generations each chain runs on its own between exchanges */
+#define TEMPER_EXCHANGE_INTERVAL 10
+
+
+struct chain_t {
+        struct ytree_t *tree;      /* Current state */
+        struct ytree_t *best;      /* Best state this chain has seen */
+        struct xoshiro_t prng;     /* Private random stream */
+        float           temp;      /* Acceptance temperature */
+        float           cost;      /* S(T) of the current state */
+        float           best_cost; /* S(T) of the best state */
+};
+
+/* State shared by the workers and the thread that runs the exchanges */
+struct ladder_t {
+        struct chain_t   *chain;     /* All of the chains */
+        struct alias_t   *alias;     /* Distribution of k (read-only) */
+        int               num_chains;
+        int               gens;      /* Generations in this round */
+        int               halt;      /* Set when there are no more rounds */
+        pthread_barrier_t barrier;   /* Workers and the exchange thread */
+};
+
+struct worker_t {
+        pthread_t        thread;
+        struct ladder_t *ladder;
+        int              first;     /* This worker runs chains first, */
+        int              stride;    /* first+stride, first+2*stride... */
+};
+
+
+/**
+ * temper_worker()
+ * ---------------
+ * Advance a fixed subset of the chains, one round at a time.
+ *
+ * @arg  : Pointer to a struct worker_t.
+ * Return: NULL
+ *
+ * NOTE
+ * Each round starts when every worker and the exchange thread
+ * reach the barrier, and ends at the next one; the exchange 
+ * thread then has the chains to itself until it starts another
+ * round, or sets @halt. The barrier orders the memory accesses
+ * on either side of it, so the chains need no lock.
+ */
+static void *temper_worker(void *arg)
+{
+        struct worker_t *w = arg;
+        struct ladder_t *l = w->ladder;
+        struct chain_t  *c;
+        int i;
+        int g;
+
+        for (;;) {
+                pthread_barrier_wait(&l->barrier);
+
+                if (l->halt) {
+                        break;
+                }
+
+                for (i=w->first; i<l->num_chains; i+=w->stride) {
+
+                        c = &l->chain[i];
+
+                        prng_bind(&c->prng);
+
+                        for (g=0; g<l->gens; g++) {
+                                c->tree = ytree_mutate_temp(c->tree, l->alias, c->temp, NULL);
+                                c->cost = ytree_cost_scaled(c->tree);
+
+                                if (c->cost > c->best_cost) {
+                                        ytree_copy_into(c->best, c->tree);
+                                        c->best_cost = c->cost;
+                                }
+                        }
+                }
+
+                prng_bind(NULL);
+
+                pthread_barrier_wait(&l->barrier);
+        }
+
+        return NULL;
+}
+
+
+/**
+ * temper_exchange()
+ * -----------------
+ * Offer neighbouring chains the chance to swap their states.
+ *
+ * @chain : Array of chains, coldest first.
+ * @n     : Number of chains.
+ * @parity: Exchange pairs (0,1),(2,3)... if 0, or (1,2),(3,4)... if 1.
+ * Return : Number of exchanges made.
+ *
+ * NOTE
+ * The swap of chains i (colder) and j (hotter) is accepted with 
+ * probability min(1, exp((S_j - S_i) * (1/T_i - 1/T_j))), which 
+ * keeps each chain sampling at its own temperature.
+ */
+static int temper_exchange(struct chain_t *chain, int n, int parity)
+{
+        struct ytree_t *tree;
+        float cost;
+        float x;
+        int swaps = 0;
+        int i;
+
+        for (i=parity; i+1<n; i+=2) {
+
+                x = (chain[i+1].cost - chain[i].cost) 
+                  * (1.0/chain[i].temp - 1.0/chain[i+1].temp);
+
+                if (x >= 0.0 || prng_uniform_random() < expf(x)) {
+                        tree              = chain[i].tree;
+                        chain[i].tree     = chain[i+1].tree;
+                        chain[i+1].tree   = tree;
+
+                        cost              = chain[i].cost;
+                        chain[i].cost     = chain[i+1].cost;
+                        chain[i+1].cost   = cost;
+
+                        swaps++;
+                }
+        }
+
+        return swaps;
+}
+
+
+/**
+ * temper_run()
+ * ------------
+ * Search for the best tree with parallel tempering.
+ *
+ * @data     : @nx@n distance matrix.
+ * @n        : Number of items.
+ * @alias    : Distribution of k for the k-mutations.
+ * @gens     : Number of generations to run each chain.
+ * @threads  : Number of worker threads.
+ * @chains   : Number of chains (temperatures).
+ * @best_cost: Filled with S(T) of the returned tree, if not NULL.
+ * Return    : Copy of the best tree seen by any chain.
+ */
+struct ytree_t *temper_run(struct ymatrix_t *data, int n, struct alias_t *alias, int gens, int threads, int chains, float *best_cost)
+{
+        struct ladder_t  ladder;
+        struct chain_t  *chain;
+        struct worker_t *worker;
+        struct ytree_t  *champion;
+        float            champion_cost;
+        float            ratio;
+        int              done;
+        int              i;
+
+        if (chains < 1) {
+                chains = 1;
+        }
+        if (threads < 1) {
+                threads = 1;
+        }
+        if (threads > chains) {
+                threads = chains;
+        }
+
+        chain  = calloc(chains,  sizeof(struct chain_t));
+        worker = calloc(threads, sizeof(struct worker_t));
+
+        /* Geometric ladder from TEMPER_T_MIN up to TEMPER_T_MAX */
+        ratio = (chains > 1) ? powf(TEMPER_T_MAX/TEMPER_T_MIN, 1.0/(chains-1)) : 1.0;
+
+        for (i=0; i<chains; i++) {
+                chain[i].tree      = ytree_create(n, data);
+                chain[i].best      = ytree_copy(chain[i].tree);
+                chain[i].temp      = TEMPER_T_MIN * powf(ratio, i);
+                chain[i].cost      = ytree_cost_scaled(chain[i].tree);
+                chain[i].best_cost = chain[i].cost;
+
+                prng_fork(&chain[i].prng);
+        }
+
+        champion      = ytree_copy(chain[0].best);
+        champion_cost = chain[0].best_cost;
+
+        ladder.chain      = chain;
+        ladder.alias      = alias;
+        ladder.num_chains = chains;
+        ladder.gens       = 0;
+        ladder.halt       = 0;
+
+        /* 
+         * The workers are started once, and meet this thread at
+         * the barrier before and after each round of generations.
+         */
+        if (pthread_barrier_init(&ladder.barrier, NULL, threads + 1) != 0) {
+                fprintf(stderr, "Could not create worker barrier.\n");
+                exit(1);
+        }
+
+        for (i=0; i<threads; i++) {
+                worker[i].ladder = &ladder;
+                worker[i].first  = i;
+                worker[i].stride = threads;
+
+                if (pthread_create(&worker[i].thread, NULL, temper_worker, &worker[i]) != 0) {
+                        fprintf(stderr, "Could not start worker thread.\n");
+                        exit(1);
+                }
+        }
+
+        for (done=0; done<gens; done+=TEMPER_EXCHANGE_INTERVAL) {
+
+                ladder.gens = TEMPER_EXCHANGE_INTERVAL;
+
+                if (done + ladder.gens > gens) {
+                        ladder.gens = gens - done;
+                }
+
+                /* Start the round, and wait for it to finish */
+                pthread_barrier_wait(&ladder.barrier);
+                pthread_barrier_wait(&ladder.barrier);
+
+                temper_exchange(chain, chains, (done/TEMPER_EXCHANGE_INTERVAL)%2);
+
+                for (i=0; i<chains; i++) {
+                        if (chain[i].best_cost > champion_cost) {
+                                ytree_copy_into(champion, chain[i].best);
+                                champion_cost = chain[i].best_cost;
+                        }
+                }
+
+                log_fitness("%f\n", champion_cost);
+
+                if (champion_cost == 1.0) {
+                        /* Halt */
+                        break;
+                }
+        }
+
+        ladder.halt = 1;
+
+        pthread_barrier_wait(&ladder.barrier);
+
+        for (i=0; i<threads; i++) {
+                pthread_join(worker[i].thread, NULL);
+        }
+
+        pthread_barrier_destroy(&ladder.barrier);
+
+        for (i=0; i<chains; i++) {
+                ytree_free(chain[i].tree);
+                ytree_free(chain[i].best);
+        }
+
+        free(chain);
+        free(worker);
+
+        if (best_cost != NULL) {
+                *best_cost = champion_cost;
+        }
+
+        return champion;
+}
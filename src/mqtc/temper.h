@@ -0,0 +1,8 @@
+#ifndef __MQTC_TEMPER
+#define __MQTC_TEMPER
+
+#include "tree/ytree.h"
+
+struct ytree_t *temper_run(struct ymatrix_t *data, int n, struct alias_t *alias, int gens, int threads, int chains, float *best_cost);
+
+#endif
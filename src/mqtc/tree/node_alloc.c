@@ -1,11 +1,35 @@
+#include <stdatomic.h>
 #include "ytree.h"
 
-static int ID = 0;
+/* Shared by every thread building or mutating a tree. */
+static atomic_uint ID = 0;
 
 /******************************************************************************
  * CREATE/COPY/DELETE
  ******************************************************************************/
 
+/**
+ * ynode_init()
+ * ------------ 
+ * Set up a node in place, with its value and a fresh identity.
+ *
+ * @n    : Node to set up (all other fields are cleared).
+ * @value: Value of the node.
+ * @key  : Key of the node (printed for leaves).
+ * Return: @n
+ */
+struct ynode_t *ynode_init(struct ynode_t *n, ynode_value_t value, ynode_value_t key)
+{
+        memset(n, 0, sizeof(struct ynode_t));
+
+        n->value = value;
+        n->id    = atomic_fetch_add(&ID, 1);
+        n->key   = key;
+
+        return n;
+}
+
+
 /**
  * ynode_create()
  * -------------- 
@@ -18,13 +42,11 @@ struct ynode_t *ynode_create(ynode_value_t value, ynode_value_t key)
 {
         struct ynode_t *n;
 
-        n = calloc(1, sizeof(struct ynode_t));
-
-        n->value = value;
-        n->id    = ID++;
-        n->key   = key;
+        if ((n = malloc(sizeof(struct ynode_t))) == NULL) {
+                return NULL;
+        }
 
-        return n;
+        return ynode_init(n, value, key);
 }
 
 
@@ -60,7 +82,8 @@ struct ynode_t *ynode_copy(struct ynode_t *n)
 
         copy = ynode_create(n->value, n->key);
 
-        copy->id = n->id;
+        copy->id  = n->id;
+        copy->sum = n->sum;
 
         copy->L = NULL;
         copy->R = NULL;
@@ -1,9 +1,20 @@
+#include <pthread.h>
 #include "ytree.h"
 
 /******************************************************************************
  * NODE COST  
  ******************************************************************************/
 
+/* Sums of an empty subtree, for nodes missing a child */
+static const struct ycost_t __impl__ycost_zero = {0};
+
+#define YCOST_OF(n) (((n) != NULL) ? &(n)->sum : &__impl__ycost_zero)
+
+static void   __impl__ynode_cost_full(struct ynode_t *n, struct ymatrix_t *d, struct ycost_t *s);
+static double __impl__ynode_cross    (struct ynode_t *a, struct ynode_t *b, struct ymatrix_t *d);
+static double __impl__ynode_cost_of  (const struct ycost_t *n, const struct ycost_t *L, const struct ycost_t *R);
+
+
 /**
  * ynode_get_cost()
  * ---------------- 
@@ -12,113 +23,204 @@
  * @n       : Pointer to node.
  * @distance: Distance matrix from which to compute the cost.
  * Return   : Cost value of @n.
+ *
+ * NOTE
+ * Computed from scratch, without the cached sums, in time
+ * O(n * leaves under @n). The side of @n away from its 
+ * children is never listed: its sums follow from the column
+ * sums of the children (see CACHED COST below).
  */
-float ynode_get_cost(struct ynode_t *n, float **distance)
+float ynode_get_cost(struct ynode_t *n, struct ymatrix_t *distance)
 {
-        struct ynode_t *root;
+        struct ycost_t L;
+        struct ycost_t R;
+        struct ycost_t s = {0};
 
-        ynode_value_t *value_L; 
-        ynode_value_t *value_R;
-        ynode_value_t *value_P;
+        if (n == NULL) {
+                return -1.0;
+        }
 
-        int count_L;
-        int count_R;
-        int count_P;
+        if (!ynode_is_internal(n) || !ynode_is_full(n)) {
+                return 0.0;
+        }
 
-        int combi_L;
-        int combi_R;
-        int combi_P;
+        __impl__ynode_cost_full(n->L, distance, &L);
+        __impl__ynode_cost_full(n->R, distance, &R);
 
-        float distance_LR = 0.0;
-        float distance_PL = 0.0;
-        float distance_PR = 0.0;
+        s.cross_LR = __impl__ynode_cross(n->L, n->R, distance);
+        s.cross_RL = __impl__ynode_cross(n->R, n->L, distance);
 
-        float cost_LR;
-        float cost_PL;
-        float cost_PR;
+        return (float)__impl__ynode_cost_of(&s, &L, &R);
+}
 
-        float cost = 0.0;
 
-        int i;
-        int j;
+/* Width of the inner loop over l; a multiple of the SIMD width. */
+#define YCOST_LANES 8
 
-        if (n == NULL) {
-                return -1.0;
-        }
+struct ybounds_t {
+        struct ymatrix_t *d;
+        int               n;
+        int               first;    /* First i handled by this worker */
+        int               stride;   /* Distance between successive i */
+        double            max;      /* Sum of quartet maxima */
+        double            min;      /* Sum of quartet minima */
+        pthread_t         thread;
+};
 
-        root = ynode_get_root(n);
 
-        count_L = ynode_count_leaves(n->L);
-        count_R = ynode_count_leaves(n->R);
-        count_P = ynode_count_leaves_not(root, n);
+/**
+ * __impl__ynode_get_cost_bounds()
+ * ------------------------------- 
+ * Sum the max and min of each quartet over a share of the i values.
+ *
+ * @arg  : Pointer to struct ybounds_t.
+ * Return: NULL.
+ *
+ * NOTE
+ * With i<j<k fixed, the three pairings of the quartet ijkl are
+ *
+ *      d[i][j] + d[k][l],  d[i][k] + d[j][l],  d[i][l] + d[j][k]
+ *
+ * which run along rows i, j and k in step with l. The l loop 
+ * is done YCOST_LANES at a time into independent accumulators,
+ * so that the compiler can keep each lane in a vector register.
+ */
+static void *__impl__ynode_get_cost_bounds(void *arg)
+{
+        struct ybounds_t *b = arg;
+        struct ymatrix_t *d = b->d;
+        int n = b->n;
+
+        float hi[YCOST_LANES];
+        float lo[YCOST_LANES];
+        float x, y, z, M, m;
+        float ij, ik, jk;
+        float *di, *dj, *dk;
+        int i, j, k, l, v;
+
+        b->max = 0.0;
+        b->min = 0.0;
+
+        for (i=b->first; i<n; i+=b->stride) {
+                di = YROW(d, i);
+                for (j=(i+1); j<n; j++) {
+                        dj = YROW(d, j);
+                        ij = di[j];
+                        for (k=(j+1); k<n; k++) {
+                                dk = YROW(d, k);
+                                ik = di[k];
+                                jk = dj[k];
 
-        combi_L = binomial(count_L, 2);
-        combi_R = binomial(count_R, 2);
-        combi_P = binomial(count_P, 2);
+                                for (v=0; v<YCOST_LANES; v++) {
+                                        hi[v] = 0.0;
+                                        lo[v] = 0.0;
+                                }
 
-        value_L = ynode_get_values(n->L);
-        value_R = ynode_get_values(n->R);
-        value_P = ynode_get_values_not(root, n);
+                                for (l=(k+1); l+YCOST_LANES<=n; l+=YCOST_LANES) {
+                                        for (v=0; v<YCOST_LANES; v++) {
+                                                x = ij + dk[l+v];
+                                                y = ik + dj[l+v];
+                                                z = di[l+v] + jk;
 
-        for (i=0; i<count_L; i++) {
-                for (j=0; j<count_R; j++) {
-                        if (value_L[i] == value_R[j]) {
-                                printf("CHAOS REIGNS\n");
-                                abort();
-                        }
-                        if (value_L[i]<=DATA_COUNT && value_R[j]<=DATA_COUNT) {
-                                distance_LR += distance[value_L[i]][value_R[j]];
+                                                M = (x > y) ? x : y;
+                                                m = (x < y) ? x : y;
+
+                                                hi[v] += (M > z) ? M : z;
+                                                lo[v] += (m < z) ? m : z;
+                                        }
+                                }
+                                for (; l<n; l++) {
+                                        x = ij + dk[l];
+                                        y = ik + dj[l];
+                                        z = di[l] + jk;
+
+                                        hi[0] += max_float(3, x, y, z);
+                                        lo[0] += min_float(3, x, y, z);
+                                }
+
+                                for (v=0; v<YCOST_LANES; v++) {
+                                        b->max += hi[v];
+                                        b->min += lo[v];
+                                }
                         }
                 }
         }
 
-        for (i=0; i<count_P; i++) {
-                for (j=0; j<count_L; j++) {
-                        if (value_P[i] == value_L[j]) {
-                                printf("CHAOS REIGNS\n");
-                                abort();
-                        }
-                        if (value_P[i]<=DATA_COUNT && value_L[j]<=DATA_COUNT) {
-                                distance_PL += distance[value_P[i]][value_L[j]];
-                        }
-                }
+        return NULL;
+}
+
+
+/**
+ * ynode_get_cost_bounds()
+ * ----------------------- 
+ * Determine the maximum and minimum cost over all trees, in one pass.
+ *
+ * @d      : Distance matrix from which to compute the cost.
+ * @n      : Number of items, i.e. @d is an @nx@n matrix.
+ * @threads: Number of threads to share the work between.
+ * @max    : Filled with the maximum cost.
+ * @min    : Filled with the minimum cost.
+ * Return  : Nothing.
+ *
+ * NOTE
+ * The bounds are sums over all C(@n,4) quartets of the 
+ * largest and smallest of the three pairings, so this is
+ * O(@n^4). The i values are dealt out to the threads in 
+ * turn, since the work for each i falls off as (n-i)^3.
+ */
+void ynode_get_cost_bounds(struct ymatrix_t *d, int n, int threads, float *max, float *min)
+{
+        struct ybounds_t *b;
+        double M;
+        double m;
+        int i;
+
+        if (threads < 1) {
+                threads = 1;
+        }
+        if (threads > n) {
+                threads = (n > 0) ? n : 1;
         }
 
-        for (i=0; i<count_P; i++) {
-                for (j=0; j<count_R; j++) {
-                        if (value_P[i] == value_R[j]) {
-                                printf("CHAOS REIGNS\n");
-                                abort();
-                        }
-                        if (value_P[i]<=DATA_COUNT && value_R[j]<=DATA_COUNT) {
-                                distance_PR += distance[value_P[i]][value_R[j]];
-                        }
-                }
+        b = calloc(threads, sizeof(struct ybounds_t));
+
+        for (i=0; i<threads; i++) {
+                b[i].d      = d;
+                b[i].n      = n;
+                b[i].first  = i;
+                b[i].stride = threads;
         }
 
-        cost_LR = (float)combi_P * distance_LR;
-        cost_PL = (float)combi_R * distance_PL;
-        cost_PR = (float)combi_L * distance_PR;
+        /* The calling thread takes the first share */
+        for (i=1; i<threads; i++) {
+                if (pthread_create(&b[i].thread, NULL, __impl__ynode_get_cost_bounds, &b[i]) != 0) {
+                        /* Do it here instead */
+                        __impl__ynode_get_cost_bounds(&b[i]);
+                        b[i].stride = 0;
+                }
+        }
 
-        cost = cost_LR + cost_PL + cost_PR;
+        __impl__ynode_get_cost_bounds(&b[0]);
 
-        /*printf("COUNT l:%d r:%d p:%d\n", count_L, count_R, count_P);*/
-        /*printf("BINOM l:%d r:%d p:%d\n", combi_L, combi_R, combi_P);*/
-        /*printf("DIST  l:%f r:%f p:%f\n", distance_PR, distance_PL, distance_LR);*/
-        /*printf("COST  l:%f r:%f p:%f\n", cost_PR, cost_PL, cost_LR);*/
-        /*printf("TOTAL %f\n", cost);*/
+        M = b[0].max;
+        m = b[0].min;
 
-        if (value_L != NULL) {
-                free(value_L);
+        for (i=1; i<threads; i++) {
+                if (b[i].stride != 0) {
+                        pthread_join(b[i].thread, NULL);
+                }
+                M += b[i].max;
+                m += b[i].min;
         }
-        if (value_R != NULL) {
-                free(value_R);
+
+        free(b);
+
+        if (max != NULL) {
+                *max = (float)M;
         }
-        if (value_P != NULL) {
-                free(value_P);
+        if (min != NULL) {
+                *min = (float)m;
         }
-
-        return cost;
 }
 
 
@@ -132,126 +234,356 @@ float ynode_get_cost(struct ynode_t *n, float **distance)
  * @n    : Number of items, i.e. @d is an @nx@n matrix.
  * Return: Maximum cost value of @n.
  */
-float ynode_get_cost_max(struct ynode_t *a, float **d, int n)
+float ynode_get_cost_max(struct ynode_t *a, struct ymatrix_t *d, int n)
 {
-        int i;
-        int j;
-        int k;
-        int l;
+        float max;
 
-        int count;
-        int combo;
-        float cost;
+        ynode_get_cost_bounds(d, n, 1, &max, NULL);
 
-        float ijkl; /* ij|kl quartet */
-        float ikjl; /* ik|jl quartet */
-        float iljk; /* il|jk quartet */
+        return max;
+}
 
-        cost  = 0.0;
-        count = 0;
-        combo = binomial(n, 4);
 
-        for (i=0; i<n; i++) {
-                for (j=(i+1); j<n; j++) {
-                        for (k=(j+1); k<n; k++) {
-                                for (l=(k+1); l<n; l++) {
+/**
+ * ynode_get_cost_min()
+ * -------------------- 
+ * Determine the minimum cost value of a particular node.
+ *
+ * @a    : Pointer to node.
+ * @d    : Distance matrix from which to compute the cost.
+ * @n    : Number of items, i.e. @d is an @nx@n matrix.
+ * Return: Minimum cost value of @n.
+ */
+float ynode_get_cost_min(struct ynode_t *a, struct ymatrix_t *d, int n)
+{
+        float min;
 
-                                        ijkl = d[i][j] + d[k][l];
-                                        ikjl = d[i][k] + d[j][l];
-                                        iljk = d[i][l] + d[j][k];
+        ynode_get_cost_bounds(d, n, 1, NULL, &min);
 
-                                        /*printf("max(%f, %f, %f) := %f\n", ijkl, ikjl, iljk, max_float(3, ijkl, ikjl, iljk));*/
+        return min;
+}
 
-                                        cost += max_float(3, ijkl, ikjl, iljk);
 
-                                        count++;
-                                }
-                        }
-                }
-        }
+/**
+ * ynode_get_cost_scaled()
+ * ----------------------- 
+ * Scale the measured cost using the max/min cost. 
+ *
+ * @c    : Measured (unscaled) cost
+ * @M    : Maximum possible cost
+ * @m    : Minimum possible cost
+ * Return: Normalized value on interval (0,1).
+ */
+float ynode_get_cost_scaled(float c, float M, float m)
+{
+        return (M - c) / (M - m);
+}
 
-        if (count != combo) {
-                fprintf(stderr, "Combination error.\n");
-                return -1.0;
+
+
+/******************************************************************************
+ * CACHED COST 
+ ******************************************************************************/
+
+/*
+ * The cost of a node depends only on the three leaf sets on
+ * either side of it, and these are summarized by the partition
+ * sums in struct ycost_t. For a node with children L and R,
+ *
+ *      d(L,R) = cross_LR
+ *      d(P,L) = L.column - L.within - cross_RL
+ *      d(P,R) = R.column - R.within - cross_LR
+ *
+ * since the columns of L sum over every leaf in the tree. 
+ * A mutation only changes the leaf sets of the nodes on the 
+ * path from the edited node to the root, so only those need 
+ * to have their sums adjusted.
+ */
+
+/**
+ * __impl__ynode_cross()
+ * --------------------- 
+ * Sum the distances from the leaves under one node to those under another.
+ *
+ * @a    : Pointer to node (rows of @d).
+ * @b    : Pointer to node (columns of @d).
+ * @d    : Distance matrix.
+ * Return: Sum of d[x][y] for x a leaf under @a, y a leaf under @b.
+ */
+static double __impl__ynode_cross(struct ynode_t *a, struct ynode_t *b, struct ymatrix_t *d)
+{
+        if (a == NULL || b == NULL) {
+                return 0.0;
+        }
+        if (a->L != NULL || a->R != NULL) {
+                return __impl__ynode_cross(a->L, b, d) + __impl__ynode_cross(a->R, b, d);
+        }
+        if (b->L != NULL || b->R != NULL) {
+                return __impl__ynode_cross(a, b->L, d) + __impl__ynode_cross(a, b->R, d);
         }
+        return (double)YDIST(d, a->value, b->value);
+}
 
-        /*printf("max cost:%f\n", cost);*/
 
-        return cost;
+/**
+ * __impl__ynode_cost_of()
+ * ----------------------- 
+ * Compute the cost of a node from its sums and those of its children.
+ *
+ * @n    : Sums of the node (only the cross sums are read).
+ * @L    : Sums of the left child.
+ * @R    : Sums of the right child.
+ * Return: Cost of the node.
+ */
+static double __impl__ynode_cost_of(const struct ycost_t *n, const struct ycost_t *L, const struct ycost_t *R)
+{
+        int count_P = DATA_COUNT - L->count - R->count;
+
+        return (double)binomial(count_P, 2)  * n->cross_LR
+             + (double)binomial(R->count, 2) * (L->column - L->within - n->cross_RL)
+             + (double)binomial(L->count, 2) * (R->column - R->within - n->cross_LR);
 }
 
 
 /**
- * ynode_get_cost_min()
- * -------------------- 
- * Determine the minimum cost value of a particular node.
+ * __impl__ynode_cost_sums()
+ * ------------------------- 
+ * Compute the sums of a node from those of its children.
  *
- * @a    : Pointer to node.
- * @d    : Distance matrix from which to compute the cost.
- * @n    : Number of items, i.e. @d is an @nx@n matrix.
- * Return: Minimum cost value of @n.
+ * @n    : Pointer to node.
+ * @L    : Sums of the left child of @n.
+ * @R    : Sums of the right child of @n.
+ * @d    : Distance matrix.
+ * @s    : Filled with the sums of @n (may be &@n->sum).
+ * Return: Nothing.
  */
-float ynode_get_cost_min(struct ynode_t *a, float **d, int n)
+static void __impl__ynode_cost_sums(struct ynode_t *n, const struct ycost_t *L, const struct ycost_t *R, struct ymatrix_t *d, struct ycost_t *s)
 {
         int i;
-        int j;
-        int k;
-        int l;
 
-        int count;
-        int combo;
-        float cost;
+        memset(s, 0, sizeof(struct ycost_t));
 
-        float ijkl; /* ij|kl quartet */
-        float ikjl; /* ik|jl quartet */
-        float iljk; /* il|jk quartet */
+        if (ynode_is_leaf(n)) {
+                s->count  = 1;
+                s->within = YDIST(d, n->value, n->value);
 
-        cost  = 0.0;
-        count = 0;
-        combo = binomial(n, 4);
+                for (i=0; i<DATA_COUNT; i++) {
+                        s->column += YDIST(d, i, n->value);
+                }
+                return;
+        }
 
-        for (i=0; i<n; i++) {
-                for (j=(i+1); j<n; j++) {
-                        for (k=(j+1); k<n; k++) {
-                                for (l=(k+1); l<n; l++) {
+        s->cross_LR = __impl__ynode_cross(n->L, n->R, d);
+        s->cross_RL = __impl__ynode_cross(n->R, n->L, d);
+        s->within   = s->cross_LR + s->cross_RL;
 
-                                        ijkl = d[i][j] + d[k][l];
-                                        ikjl = d[i][k] + d[j][l];
-                                        iljk = d[i][l] + d[j][k];
+        s->count  += L->count  + R->count;
+        s->column += L->column + R->column;
+        s->within += L->within + R->within;
 
-                                        /*printf("min(%f, %f, %f) := %f\n", ijkl, ikjl, iljk, min_float(3, ijkl, ikjl, iljk));*/
+        if (ynode_is_internal(n) && ynode_is_full(n)) {
+                s->total = __impl__ynode_cost_of(s, L, R);
+        }
 
-                                        cost += min_float(3, ijkl, ikjl, iljk);
+        s->total += L->total + R->total;
+}
 
-                                        count++;
-                                }
-                        }
+
+/**
+ * __impl__ynode_cost_total()
+ * -------------------------- 
+ * Recompute the cost of a node and the total cost below it. 
+ *
+ * @n    : Pointer to node (children must be current).
+ * Return: Nothing.
+ *
+ * NOTE
+ * This is ynode_get_cost() computed from the cached sums.
+ */
+static void __impl__ynode_cost_total(struct ynode_t *n)
+{
+        double cost = 0.0;
+
+        if (ynode_is_internal(n) && ynode_is_full(n)) {
+                cost = __impl__ynode_cost_of(&n->sum, &n->L->sum, &n->R->sum);
+        }
+
+        n->sum.total = cost 
+                     + ((n->L != NULL) ? n->L->sum.total : 0.0)
+                     + ((n->R != NULL) ? n->R->sum.total : 0.0);
+}
+
+
+/**
+ * __impl__ynode_cost_walk()
+ * ------------------------- 
+ * Add or remove the leaves of a subtree from the sums on the path to the root.
+ *
+ * @u    : First node on the path (the parent of the slot @n occupies).
+ * @c    : Child of @u on the path (@n, or NULL if @n was unlinked).
+ * @n    : Subtree being added or removed.
+ * @d    : Distance matrix.
+ * @sign : +1 to add the leaves of @n, -1 to remove them. 
+ * Return: Nothing.
+ */
+static void __impl__ynode_cost_walk(struct ynode_t *u, struct ynode_t *c, struct ynode_t *n, struct ymatrix_t *d, int sign)
+{
+        struct ynode_t *s;
+        double x;
+        double y;
+        double to   = 0.0; /* d(n, u-n) */
+        double from = 0.0; /* d(u-n, n) */
+
+        for (; u != NULL; c = u, u = u->P) {
+
+                s = (u->L == c) ? u->R : u->L;
+                x = __impl__ynode_cross(n, s, d);
+                y = __impl__ynode_cross(s, n, d);
+
+                if (u->L == c) {
+                        u->sum.cross_LR += sign * x;
+                        u->sum.cross_RL += sign * y;
+                } else {
+                        u->sum.cross_LR += sign * y;
+                        u->sum.cross_RL += sign * x;
                 }
+
+                to   += x;
+                from += y;
+
+                u->sum.count  += sign * n->sum.count;
+                u->sum.column += sign * n->sum.column;
+                u->sum.within += sign * (n->sum.within + to + from);
+
+                __impl__ynode_cost_total(u);
         }
+}
 
-        if (count != combo) {
-                fprintf(stderr, "Combination error.\n");
-                return -1.0;
+
+/**
+ * ynode_cost_init()
+ * ----------------- 
+ * Compute the cached sums of every node under a node.
+ *
+ * @n    : Pointer to root or pseudo-root node.
+ * @d    : Distance matrix from which to compute the cost.
+ * Return: Nothing.
+ */
+void ynode_cost_init(struct ynode_t *n, struct ymatrix_t *d)
+{
+        if (n == NULL) {
+                return;
         }
 
-        /*printf("min cost:%f\n", cost);*/
+        ynode_cost_init(n->L, d);
+        ynode_cost_init(n->R, d);
 
-        return cost;
+        __impl__ynode_cost_sums(n, YCOST_OF(n->L), YCOST_OF(n->R), d, &n->sum);
 }
 
 
 /**
- * ynode_get_cost_scaled()
- * ----------------------- 
- * Scale the measured cost using the max/min cost. 
+ * __impl__ynode_cost_full()
+ * ------------------------- 
+ * Compute the sums of a node from scratch, leaving the cached sums alone.
  *
- * @c    : Measured (unscaled) cost
- * @M    : Maximum possible cost
- * @m    : Minimum possible cost
- * Return: Normalized value on interval (0,1).
+ * @n    : Pointer to node, or NULL.
+ * @d    : Distance matrix.
+ * @s    : Filled with the sums of @n.
+ * Return: Nothing.
+ *
+ * NOTE
+ * The sums of the children are held on the stack, so this
+ * allocates nothing; the stack depth is the height of @n.
  */
-float ynode_get_cost_scaled(float c, float M, float m)
+static void __impl__ynode_cost_full(struct ynode_t *n, struct ymatrix_t *d, struct ycost_t *s)
 {
-        return (M - c) / (M - m);
+        struct ycost_t L;
+        struct ycost_t R;
+
+        if (n == NULL) {
+                memset(s, 0, sizeof(struct ycost_t));
+                return;
+        }
+
+        __impl__ynode_cost_full(n->L, d, &L);
+        __impl__ynode_cost_full(n->R, d, &R);
+        __impl__ynode_cost_sums(n, &L, &R, d, s);
+}
+
+
+/**
+ * ynode_get_cost_total()
+ * ---------------------- 
+ * Compute the total cost of every node under a node, from scratch.
+ *
+ * @n    : Pointer to root or pseudo-root node.
+ * @d    : Distance matrix from which to compute the cost.
+ * Return: Sum of the node costs under @n.
+ *
+ * NOTE
+ * This is the reference for the cached sums: it reads no
+ * cached sum, and takes O(n^2) in all, since each pair of
+ * leaves is summed once, at the node where they part, and 
+ * each leaf sums one column of @d.
+ */
+double ynode_get_cost_total(struct ynode_t *n, struct ymatrix_t *d)
+{
+        struct ycost_t s;
+
+        __impl__ynode_cost_full(n, d, &s);
+
+        return s.total;
 }
 
+
+/**
+ * ynode_cost_update()
+ * ------------------- 
+ * Refresh the cost totals on the path from a node to the root.
+ *
+ * @n    : Pointer to node whose own cost has changed.
+ * Return: Nothing.
+ *
+ * NOTE
+ * Use this when the leaf sets are unchanged, e.g. when
+ * the children of @n have only traded places.
+ */
+void ynode_cost_update(struct ynode_t *n)
+{
+        for (; n != NULL; n = n->P) {
+                __impl__ynode_cost_total(n);
+        }
+}
+
+
+/**
+ * ynode_cost_remove()
+ * ------------------- 
+ * Update the cached sums after a subtree has been unlinked. 
+ *
+ * @p    : Former parent of @n (the slot of @n must now be NULL).
+ * @n    : Subtree which was removed.
+ * @d    : Distance matrix.
+ * Return: Nothing.
+ */
+void ynode_cost_remove(struct ynode_t *p, struct ynode_t *n, struct ymatrix_t *d)
+{
+        __impl__ynode_cost_walk(p, NULL, n, d, -1);
+}
+
+
+/**
+ * ynode_cost_insert()
+ * ------------------- 
+ * Update the cached sums after a subtree has been linked. 
+ *
+ * @p    : New parent of @n.
+ * @n    : Subtree which was inserted.
+ * @d    : Distance matrix.
+ * Return: Nothing.
+ */
+void ynode_cost_insert(struct ynode_t *p, struct ynode_t *n, struct ymatrix_t *d)
+{
+        __impl__ynode_cost_walk(p, n, n, d, +1);
+}
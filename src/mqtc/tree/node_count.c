@@ -4,29 +4,37 @@
  * COUNTS 
  ******************************************************************************/
 
-int             Count = 0; 
-struct ynode_t *Exclude;
+struct ycount_t {
+        int             count;
+        struct ynode_t *exclude;
+};
 
-void __impl__ynode_count_leaves(struct ynode_t *n, int i)
+static void __impl__ynode_count_leaves(struct ynode_t *n, int i, void *arg)
 {
+        struct ycount_t *c = arg;
+
         if (ynode_is_leaf(n) && n->value != YTREE_INTERNAL_NODE_LABEL) {
-                Count++;
+                c->count++;
         }
 }
 
-void __impl__ynode_count_leaves_not(struct ynode_t *n, int i)
+static void __impl__ynode_count_leaves_not(struct ynode_t *n, int i, void *arg)
 {
+        struct ycount_t *c = arg;
+
         if (ynode_is_leaf(n) && n->value != YTREE_INTERNAL_NODE_LABEL) {
-                if (!ynode_is_subtree_of(n, Exclude)) {
-                        Count++;
+                if (!ynode_is_subtree_of(n, c->exclude)) {
+                        c->count++;
                 }
         }
 }
 
-void __impl__ynode_count_internal(struct ynode_t *n, int i)
+static void __impl__ynode_count_internal(struct ynode_t *n, int i, void *arg)
 {
+        struct ycount_t *c = arg;
+
         if (ynode_is_internal(n)) {
-                Count++;
+                c->count++;
         }
 }
 
@@ -41,10 +49,11 @@ void __impl__ynode_count_internal(struct ynode_t *n, int i)
  */
 int ynode_count_leaves(struct ynode_t *n)
 {
-        Count = 0;
-        ynode_traverse_inorder(n, __impl__ynode_count_leaves);
+        struct ycount_t c = { 0, NULL };
 
-        return Count;
+        ynode_traverse_inorder(n, __impl__ynode_count_leaves, &c);
+
+        return c.count;
 }
 
 
@@ -59,11 +68,11 @@ int ynode_count_leaves(struct ynode_t *n)
  */
 int ynode_count_leaves_not(struct ynode_t *n, struct ynode_t *x)
 {
-        Count   = 0;
-        Exclude = x;
-        ynode_traverse_inorder(n, __impl__ynode_count_leaves_not);
+        struct ycount_t c = { 0, x };
+
+        ynode_traverse_inorder(n, __impl__ynode_count_leaves_not, &c);
 
-        return Count;
+        return c.count;
 }
 
 
@@ -77,8 +86,9 @@ int ynode_count_leaves_not(struct ynode_t *n, struct ynode_t *x)
  */
 int ynode_count_internal(struct ynode_t *n)
 {
-        Count = 0;
-        ynode_traverse_inorder(n, __impl__ynode_count_internal);
+        struct ycount_t c = { 0, NULL };
+
+        ynode_traverse_inorder(n, __impl__ynode_count_internal, &c);
 
-        return Count;
+        return c.count;
 }
@@ -68,7 +68,7 @@ struct ynode_t *ynode_add_left_level(struct ynode_t *n, ynode_value_t value, yno
 {
         n->L     = ynode_create(value, key);
         n->R     = ynode_create(n->value, n->key);
-        n->value = '.';
+        n->value = YTREE_INTERNAL_NODE_LABEL;
 
         n->R->P = n;
         n->L->P = n;
@@ -96,7 +96,7 @@ struct ynode_t *ynode_add_right_level(struct ynode_t *n, ynode_value_t value, yn
 {
         n->R     = ynode_create(value, key);
         n->L     = ynode_create(n->value, n->key);
-        n->value = '.';
+        n->value = YTREE_INTERNAL_NODE_LABEL;
 
         n->R->P = n;
         n->L->P = n;
@@ -115,30 +115,54 @@ struct ynode_t *ynode_add_right_level(struct ynode_t *n, ynode_value_t value, yn
  * Return: Pointer to the created node, or NULL.
  */
 struct ynode_t *ynode_add_before(struct ynode_t *a, ynode_value_t value, ynode_value_t key)
+{
+        return ynode_link_before(a, ynode_create(value, key));
+}
+
+
+/**
+ * ynode_link_before()
+ * ------------------- 
+ * Link an existing, unlinked node between the given node and its parent. 
+ * 
+ * @a    : Node before which @n will be linked. 
+ * @n    : Node to link (its relations are overwritten).
+ * Return: @n.
+ *
+ * NOTE
+ * This lets a mutation re-use a node it has just removed
+ * from the tree, so that the node store of a tree never
+ * has to grow or shrink.
+ */
+struct ynode_t *ynode_link_before(struct ynode_t *a, struct ynode_t *n)
 {
         struct ynode_t *par;
-        struct ynode_t *new;
 
         /* Store the parent */
         par = a->P;
 
         /* Insert the new node between a and parent(a). */
-        new = ynode_create(value, key);
+        a->P = n;
+        n->P = par;
+        n->L = NULL;
+        n->R = NULL;
 
-        a->P   = new;
-        new->P = par;
-
-        if (par->L && (par->L->id == a->id)) {
+        if (par->L == a) {
                 /* A was the left child */
-                new->L = a;
-                par->L = new;
+                n->L   = a;
+                par->L = n;
         } else {
                 /* A was the right child */
-                new->R = a;
-                par->R = new;
+                n->R   = a;
+                par->R = n;
         }
 
-        return new;
+        /* The new node covers exactly the leaves of A */
+        n->sum          = a->sum;
+        n->sum.cross_LR = 0.0;
+        n->sum.cross_RL = 0.0;
+
+        return n;
 }
 
 
@@ -245,7 +269,8 @@ struct ynode_t *ynode_insert(struct ynode_t *n, ynode_value_t value, ynode_value
  * Return: Nothing. 
  *
  * NOTE
- * For creating a path from a node, see ynode_get_path().
+ * The path is read from the root down; 'L' goes to the left
+ * child and 'R' to the right.
  */
 void ynode_insert_on_path(struct ynode_t *r, struct ynode_t *a, char *path)
 {
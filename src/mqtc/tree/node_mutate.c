@@ -116,6 +116,196 @@ struct ynode_t *ynode_promote(struct ynode_t *n)
         return NULL;
 }
 
+/**
+ * ynode_detach()
+ * -------------- 
+ * Unlink a subtree from its parent, leaving an empty slot.
+ * 
+ * @n    : Node to unlink (subtree goes with it)
+ * @d    : Distance matrix (for the cached sums)
+ * Return: Former parent of @n, or NULL.
+ *
+ *      x               x 
+ *     / \               \
+ *    n   B               B     n
+ */
+struct ynode_t *ynode_detach(struct ynode_t *n, struct ymatrix_t *d)
+{
+        struct ynode_t *par;
+
+        if (n == NULL || n->P == NULL) {
+                return NULL;
+        }
+
+        par = n->P;
+
+        if (par->L == n) {
+                par->L = NULL;
+        } else {
+                par->R = NULL;
+        }
+
+        n->P = NULL;
+
+        ynode_cost_remove(par, n, d);
+
+        return par;
+}
+
+
+/**
+ * ynode_attach()
+ * -------------- 
+ * Link a subtree into the empty slot of a node.
+ * 
+ * @p    : Node with an empty slot (left is filled first)
+ * @n    : Node to link (subtree goes with it)
+ * @d    : Distance matrix (for the cached sums)
+ * Return: Nothing.
+ *
+ *      x               x 
+ *       \             / \
+ *        B   n       n   B
+ */
+void ynode_attach(struct ynode_t *p, struct ynode_t *n, struct ymatrix_t *d)
+{
+        if (p == NULL || n == NULL) {
+                return;
+        }
+
+        if (p->L == NULL) {
+                p->L = n;
+        } else {
+                p->R = n;
+        }
+
+        n->P = p;
+
+        ynode_cost_insert(p, n, d);
+}
+
+
+/**
+ * ynode_swap_children()
+ * --------------------- 
+ * Exchange the left and right children of a node.
+ * 
+ * @n    : Node whose children will be exchanged 
+ * Return: Nothing.
+ */
+static void ynode_swap_children(struct ynode_t *n)
+{
+        struct ynode_t *tmp;
+        double          sum;
+
+        tmp  = n->L;
+        n->L = n->R;
+        n->R = tmp;
+
+        sum             = n->sum.cross_LR;
+        n->sum.cross_LR = n->sum.cross_RL;
+        n->sum.cross_RL = sum;
+
+        ynode_cost_update(n);
+}
+
+
+/**
+ * ynode_subtree_interchange()
+ * --------------------------- 
+ * Exchange two subtrees, without checking that this is allowed.
+ *
+ * @a    : Pointer to (leaf/internal) node
+ * @b    : Pointer to (leaf/internal) node
+ * @d    : Distance matrix (for the cached sums)
+ * Return: Nothing.
+ *
+ * NOTE
+ * @a and @b must be disjoint, and neither may be the root
+ * or the sibling of the other. ynode_SUBTREE_INTERCHANGE() 
+ * checks this first; callers that already know it can come 
+ * here directly.
+ */
+void ynode_subtree_interchange(struct ynode_t *a, struct ynode_t *b, struct ymatrix_t *d)
+{
+        struct ynode_t *a_parent;
+        struct ynode_t *b_parent;
+
+        /* 
+         * Each subtree takes the slot the other
+         * one left behind.
+         */
+        a_parent = ynode_detach(a, d);
+        b_parent = ynode_detach(b, d);
+
+        ynode_attach(a_parent, b, d);
+        ynode_attach(b_parent, a, d);
+}
+
+
+/**
+ * ynode_subtree_transfer()
+ * ------------------------ 
+ * Graft one subtree at another, without checking that this is allowed.
+ *
+ * @a    : Pointer to (leaf/internal) node
+ * @b    : Pointer to (leaf/internal) node
+ * @d    : Distance matrix (for the cached sums)
+ * Return: Nothing.
+ *
+ * NOTE
+ * Same conditions as ynode_subtree_interchange(), which 
+ * ynode_SUBTREE_TRANSFER() checks first.
+ */
+void ynode_subtree_transfer(struct ynode_t *a, struct ynode_t *b, struct ymatrix_t *d)
+{
+        struct ynode_t *par;
+        struct ynode_t *sib;
+        struct ynode_t *new;
+
+        sib = ynode_get_sibling(a);
+
+        if (ynode_is_root(a->P) && !ynode_is_internal(sib)) {
+                /* Nowhere for b to be; nothing to do. */
+                return;
+        }
+
+        /* Detach a from the parent */
+        par = ynode_detach(a, d);
+
+        if (ynode_is_root(par)) {
+                /* 
+                 * Preserve the root, but prevent an extra 
+                 * internal node sneaking in when the root 
+                 * is the parent of a, by copying the 
+                 * remaining sibling to the root, and then 
+                 * removing it. 
+                 */
+                par->L    = sib->L;
+                par->R    = sib->R;
+                par->L->P = par;
+                par->R->P = par;
+                par->sum  = sib->sum;
+                ynode_cost_update(par);
+                new = sib;
+        } else {
+                /*
+                 * Promote the sibling normally, if the
+                 * parent node is not the root node. 
+                 */
+                new = ynode_promote(sib);
+        }
+
+        /* 
+         * Graft a onto the edge above b, re-using
+         * the internal node that was just removed.
+         */
+        ynode_link_before(b, new);
+
+        ynode_attach(new, a, d);
+}
+
+
 /******************************************************************************
  * ynode MUTATION  
  ******************************************************************************/
@@ -127,39 +317,25 @@ struct ynode_t *ynode_promote(struct ynode_t *n)
  *
  * @a    : Pointer to (leaf) node
  * @b    : Pointer to (leaf) node
+ * @d    : Distance matrix (for the cached sums)
  * Return: Nothing.
  */
-void ynode_LEAF_INTERCHANGE(struct ynode_t *a, struct ynode_t *b)
+void ynode_LEAF_INTERCHANGE(struct ynode_t *a, struct ynode_t *b, struct ymatrix_t *d)
 {
-        struct ynode_t *a_par;
-        struct ynode_t *b_par;
-
         if (a != NULL && b != NULL) {
-
-                if (a->id == b->id) {
-                        /* Swap will do nothing */
+                if (!ynode_is_leaf(a) || !ynode_is_leaf(b)) {
                         return;
                 }
-
-                if (a->P != NULL && b->P != NULL) {
-                        a_par = a->P;
-                        b_par = b->P;
-
-                        if (ynode_is_left_child(a)) {
-                                a_par->L = b;
-                        } else {
-                                a_par->R = b;
-                        }
-
-                        if (ynode_is_left_child(b)) {
-                                b_par->L = a;
-                        } else {
-                                b_par->R = a;
-                        }
-
-                        a->P  = b->P;
-                        b->P  = a_par;
+                if (ynode_is_equal(a, b)) {
+                        return;
                 }
+                if (ynode_is_sibling(a, b)) {
+                        ynode_swap_children(a->P);
+                        return;
+                }
+
+                /* Two different leaves are always disjoint */
+                ynode_subtree_interchange(a, b, d);
         }
 }
 
@@ -171,13 +347,11 @@ void ynode_LEAF_INTERCHANGE(struct ynode_t *a, struct ynode_t *b)
  *
  * @a    : Pointer to (leaf/internal) node
  * @b    : Pointer to (leaf/internal) node
+ * @d    : Distance matrix (for the cached sums)
  * Return: Nothing.
  */
-void ynode_SUBTREE_INTERCHANGE(struct ynode_t *a, struct ynode_t *b)
+void ynode_SUBTREE_INTERCHANGE(struct ynode_t *a, struct ynode_t *b, struct ymatrix_t *d)
 {
-        struct ynode_t *a_parent;
-        struct ynode_t *b_parent;
-
         if (a != NULL && b != NULL) {
                 if (ynode_is_equal(a, b)) {
                         /*printf("Identical subtrees. Interchange declined\n");*/
@@ -191,13 +365,7 @@ void ynode_SUBTREE_INTERCHANGE(struct ynode_t *a, struct ynode_t *b)
 
                         if (ynode_is_sibling(a, b)) {
                                 /*printf("Sibling nodes.\n");*/
-                                if (ynode_is_left_child(a)) {
-                                        a->P->L = b;
-                                        a->P->R = a;
-                                } else {
-                                        a->P->L = a;
-                                        a->P->R = b;
-                                }
+                                ynode_swap_children(a->P);
                                 return;
                         }
 
@@ -206,23 +374,7 @@ void ynode_SUBTREE_INTERCHANGE(struct ynode_t *a, struct ynode_t *b)
                                 return;
                         }
 
-                        a_parent = a->P;
-                        b_parent = b->P;
-
-                        if (ynode_is_left_child(a)) {
-                                a_parent->L = b;
-                        } else {
-                                a_parent->R = b;
-                        }
-
-                        if (ynode_is_left_child(b)) {
-                                b_parent->L = a;
-                        } else {
-                                b_parent->R = a;
-                        }
-
-                        a->P = b_parent;
-                        b->P = a_parent;
+                        ynode_subtree_interchange(a, b, d);
                 }
         }
 }
@@ -235,15 +387,11 @@ void ynode_SUBTREE_INTERCHANGE(struct ynode_t *a, struct ynode_t *b)
  *
  * @a    : Pointer to (leaf/internal) node
  * @b    : Pointer to (leaf/internal) node
+ * @d    : Distance matrix (for the cached sums)
  * Return: Nothing.
  */
-void ynode_SUBTREE_TRANSFER(struct ynode_t *a, struct ynode_t *b)
+void ynode_SUBTREE_TRANSFER(struct ynode_t *a, struct ynode_t *b, struct ymatrix_t *d)
 {
-        struct ynode_t *par;
-        struct ynode_t *del;
-        struct ynode_t *sib;
-        struct ynode_t *new;
-
         if (a != NULL && b != NULL) {
                 if (ynode_is_equal(a, b)) {
                         /*printf("Identical subtrees. Transfer declined\n");*/
@@ -258,13 +406,7 @@ void ynode_SUBTREE_TRANSFER(struct ynode_t *a, struct ynode_t *b)
 
                         if (ynode_is_sibling(a, b)) {
                                 /*printf("Sibling nodes: %d and %d.\n", a->id, b->id);*/
-                                if (ynode_is_left_child(a)) {
-                                        a->P->L = b;
-                                        a->P->R = a;
-                                } else {
-                                        a->P->L = a;
-                                        a->P->R = b;
-                                }
+                                ynode_swap_children(a->P);
                                 return;
                         }
 
@@ -273,50 +415,7 @@ void ynode_SUBTREE_TRANSFER(struct ynode_t *a, struct ynode_t *b)
                                 return;
                         }
 
-                        new  = ynode_add_before(b, '.', '.');
-                        sib  = ynode_get_sibling(a);
-                        par  = a->P;
-                        a->P = new;
-
-                        if (new->L == NULL) {
-                                new->L = a;
-                        } else {
-                                new->R = a;
-                        }
-
-                        /* Detach a from the parent */
-                        if (par->L && par->L->id == a->id) {
-                                par->L = NULL;
-                                sib    = par->R;
-                        } else {
-                                par->R = NULL;
-                                sib    = par->L;
-                        }
-
-                        if (ynode_is_root(par)) {
-                                /* 
-                                 * Preserve the root, but prevent an extra 
-                                 * internal node sneaking in when the root 
-                                 * is the parent of a, by copying the 
-                                 * remaining sibling to the root, and then 
-                                 * removing it. 
-                                 */
-                                if (ynode_is_internal(sib)) {
-                                        par->L = sib->L;
-                                        par->R = sib->R;
-                                        par->L->P = par;
-                                        par->R->P = par;
-                                        ynode_destroy(sib);
-                                }
-                        } else {
-                                /*
-                                 * Promote the sibling normally, if the
-                                 * parent node is not the root node. 
-                                 */
-                                del = ynode_promote(sib);
-                                ynode_destroy(del);
-                        }
-
+                        ynode_subtree_transfer(a, b, d);
                 }
         }
 }
@@ -99,7 +99,7 @@ struct asciinode_t *build_ascii_tree_recursive(struct ynode_t *n, const char *fm
                 node->R->parent_dir = 1;
         }
 
-        if (n->value == '.') {
+        if (n->value == YTREE_INTERNAL_NODE_LABEL) {
                 sprintf(node->label, ".");
         } else {
                 sprintf(node->label, fmt, n->key);
@@ -4,34 +4,38 @@
  * TRAVERSAL 
  ******************************************************************************/
 
-static int Traversal_index = 1; 
+/*
+ * The visit index is threaded through the recursion, rather 
+ * than kept in a global, so that traversals may run on any 
+ * number of trees at once.
+ */
 
-void __impl__ynode_traverse_inorder(struct ynode_t *n, ynode_traverse_cb visit)
+static void __impl__ynode_traverse_inorder(struct ynode_t *n, ynode_traverse_cb visit, void *arg, int *i)
 {
         if (n != NULL) {
-                __impl__ynode_traverse_inorder(n->L, visit);
-                visit(n, Traversal_index++);
-                __impl__ynode_traverse_inorder(n->R, visit);
+                __impl__ynode_traverse_inorder(n->L, visit, arg, i);
+                visit(n, (*i)++, arg);
+                __impl__ynode_traverse_inorder(n->R, visit, arg, i);
         }
         return;
 }
 
-void __impl__ynode_traverse_preorder(struct ynode_t *n, ynode_traverse_cb visit)
+static void __impl__ynode_traverse_preorder(struct ynode_t *n, ynode_traverse_cb visit, void *arg, int *i)
 {
         if (n != NULL) {
-                visit(n, Traversal_index++);
-                __impl__ynode_traverse_preorder(n->L, visit);
-                __impl__ynode_traverse_preorder(n->R, visit);
+                visit(n, (*i)++, arg);
+                __impl__ynode_traverse_preorder(n->L, visit, arg, i);
+                __impl__ynode_traverse_preorder(n->R, visit, arg, i);
         }
         return;
 }
 
-void __impl__ynode_traverse_postorder(struct ynode_t *n, ynode_traverse_cb visit)
+static void __impl__ynode_traverse_postorder(struct ynode_t *n, ynode_traverse_cb visit, void *arg, int *i)
 {
         if (n != NULL) {
-                visit(n, Traversal_index++);
-                __impl__ynode_traverse_postorder(n->L, visit);
-                __impl__ynode_traverse_postorder(n->R, visit);
+                __impl__ynode_traverse_postorder(n->L, visit, arg, i);
+                __impl__ynode_traverse_postorder(n->R, visit, arg, i);
+                visit(n, (*i)++, arg);
         }
         return;
 }
@@ -43,13 +47,15 @@ void __impl__ynode_traverse_postorder(struct ynode_t *n, ynode_traverse_cb visit
  *
  * @n    : Node to begin traversal from
  * @visit: Callback applied at each node in the traversal.
+ * @arg  : User pointer passed to each call of @visit.
  * Return: Nothing
  */
-void ynode_traverse_inorder(struct ynode_t *n, ynode_traverse_cb visit)
+void ynode_traverse_inorder(struct ynode_t *n, ynode_traverse_cb visit, void *arg)
 {
-        Traversal_index = 1; /* prevent division by 0 */
+        int i = 1; /* prevent division by 0 */
+
         if (n != NULL) {
-                __impl__ynode_traverse_inorder(n, visit);
+                __impl__ynode_traverse_inorder(n, visit, arg, &i);
         }
 }
 
@@ -60,13 +66,15 @@ void ynode_traverse_inorder(struct ynode_t *n, ynode_traverse_cb visit)
  *
  * @n    : Node to begin traversal from
  * @visit: Callback applied at each node in the traversal.
+ * @arg  : User pointer passed to each call of @visit.
  * Return: Nothing
  */
-void ynode_traverse_preorder(struct ynode_t *n, ynode_traverse_cb visit)
+void ynode_traverse_preorder(struct ynode_t *n, ynode_traverse_cb visit, void *arg)
 {
-        Traversal_index = 1;
+        int i = 1;
+
         if (n != NULL) {
-                __impl__ynode_traverse_preorder(n, visit);
+                __impl__ynode_traverse_preorder(n, visit, arg, &i);
         }
         return;
 }
@@ -78,13 +86,15 @@ void ynode_traverse_preorder(struct ynode_t *n, ynode_traverse_cb visit)
  *
  * @n    : Node to begin traversal from
  * @visit: Callback applied at each node in the traversal.
+ * @arg  : User pointer passed to each call of @visit.
  * Return: Nothing
  */
-void ynode_traverse_postorder(struct ynode_t *n, ynode_traverse_cb visit)
+void ynode_traverse_postorder(struct ynode_t *n, ynode_traverse_cb visit, void *arg)
 {
-        Traversal_index = 1;
+        int i = 1;
+
         if (n != NULL) {
-                __impl__ynode_traverse_postorder(n, visit);
+                __impl__ynode_traverse_postorder(n, visit, arg, &i);
         }
         return;
 }
@@ -4,6 +4,115 @@
  * TREE CREATE 
  ******************************************************************************/
 
+/**
+ * __impl__ytree_pack()
+ * -------------------- 
+ * Copy a freshly built tree into a contiguous node store, in preorder.
+ *
+ * @n    : Node to copy (subtree goes with it)
+ * @store: Node store of the tree
+ * @k    : Next free entry in @store
+ * Return: Pointer to the entry now holding @n.
+ */
+static struct ynode_t *__impl__ytree_pack(struct ynode_t *n, struct ynode_t *store, int *k)
+{
+        struct ynode_t *slot;
+
+        if (n == NULL) {
+                return NULL;
+        }
+
+        slot  = &store[(*k)++];
+        *slot = *n;
+
+        slot->L = __impl__ytree_pack(n->L, store, k);
+        slot->R = __impl__ytree_pack(n->R, store, k);
+
+        if (slot->L != NULL) {
+                slot->L->P = slot;
+        }
+        if (slot->R != NULL) {
+                slot->R->P = slot;
+        }
+
+        return slot;
+}
+
+
+/**
+ * __impl__ytree_random()
+ * ---------------------- 
+ * Build a uniformly random tree over @n leaves, in a node array.
+ *
+ * @n    : Number of leaves.
+ * @data : Distance matrix (for the leaf keys).
+ * @node : Array with room for the root, @n leaves and @n-2 internal
+ *         nodes; the root is put at entry 0.
+ * Return: Nothing.
+ *
+ * NOTE
+ * Leaves 0 and 1 start out as the children of the root, and 
+ * leaf k is then joined to the middle of an edge picked at 
+ * random from the 2k-3 edges of the tree so far. Every
+ * unrooted ternary tree on the leaves comes from exactly one 
+ * sequence of picks [Felsenstein 2004], so all are equally
+ * likely. The two edges at the root are one edge of the 
+ * unrooted tree, so only the left one is ever picked.
+ *
+ * Nodes are placed by index, so this takes O(@n) in all.
+ */
+static void __impl__ytree_random(int n, struct ymatrix_t *data, struct ynode_t *node)
+{
+        struct ynode_t *root = &node[0];
+        struct ynode_t *leaf;
+        struct ynode_t *in;
+        struct ynode_t *x;
+        int m = 1;
+        int r;
+        int k;
+
+        ynode_init(root, 0, 0);
+
+        for (k=0; k<n && k<2; k++) {
+                leaf    = ynode_init(&node[m++], k, YLABEL(data, k));
+                leaf->P = root;
+
+                if (k == 0) {
+                        root->L = leaf;
+                } else {
+                        root->R = leaf;
+                }
+        }
+
+        for (k=2; k<n; k++) {
+                /* Edges above node[1..m-1], without node[2] (root->R) */
+                r = dice_roll(2*k - 3);
+                x = &node[(r == 0) ? 1 : r + 2];
+
+                in   = ynode_init(&node[m++], YTREE_INTERNAL_NODE_LABEL, YTREE_INTERNAL_NODE_LABEL);
+                leaf = ynode_init(&node[m++], k, YLABEL(data, k));
+
+                if (x->P->L == x) {
+                        x->P->L = in;
+                } else {
+                        x->P->R = in;
+                }
+
+                in->P   = x->P;
+                x->P    = in;
+                leaf->P = in;
+
+                if (coin_fair()) {
+                        in->L = x;
+                        in->R = leaf;
+                } else {
+                        in->L = leaf;
+                        in->R = x;
+                }
+        }
+}
+
+
 /**
  * ytree_create()
  * -------------- 
@@ -12,30 +121,69 @@
  * @n    : Number of data points
  * @data : @nx@n data matrix.
  * Return: Pointer to a tree structure.
+ *
+ * NOTE
+ * The tree is drawn uniformly from all trees over the @n
+ * points (see __impl__ytree_random()). Leaf i has value i,
+ * its row in @data, and key YLABEL(@data, i), the index it 
+ * had in the input, which is what is printed.
+ *
+ * All nodes of the tree live in one array, @tree->node, 
+ * with the root at entry 0. The mutation operators only 
+ * re-link nodes that are already in the tree, so the
+ * store is allocated once here and never changes size.
  */
-struct ytree_t *ytree_create(int n, float **data)
+struct ytree_t *ytree_create(int n, struct ymatrix_t *data)
 {
         struct ytree_t *tree;
+        struct ynode_t *build;
         int i;
+        int k;
+        int m;
 
         tree = calloc(1, sizeof(struct ytree_t));
 
-        tree->root = ynode_create_root();
-        tree->data = data;
-
-        for (i=0; i<n; i++) {
-                ynode_insert(tree->root, i, i);
-                if (!ynode_is_ternary(tree->root)) {
-                        fprintf(stderr, "Malformed tree.\n");
-                        exit(1);
+        tree->data         = data;
+        tree->count        = n;
+        tree->num_leaves   = n;
+        tree->num_internal = (n > 2) ? n - 2 : 0;
+        tree->num_nodes    = tree->num_leaves + tree->num_internal + 1; 
+
+        /*
+         * Built in one array, then copied into the store in
+         * preorder, so that subtrees are close in memory.
+         */
+        build      = calloc(tree->num_nodes, sizeof(struct ynode_t));
+        tree->node = calloc(tree->num_nodes, sizeof(struct ynode_t));
+
+        __impl__ytree_random(n, data, build);
+
+        i = 0;
+        tree->root = __impl__ytree_pack(&build[0], tree->node, &i);
+        tree->root->P = NULL;
+
+        free(build);
+
+        /* 
+         * Nodes never change slot, or change between leaf 
+         * and internal, so these are fixed from here on. 
+         */
+        tree->leaf     = calloc(tree->num_leaves,   sizeof(int));
+        tree->internal = calloc(tree->num_internal, sizeof(int));
+        tree->enter    = calloc(tree->num_nodes,    sizeof(int));
+        tree->leave    = calloc(tree->num_nodes,    sizeof(int));
+
+        for (i=1, k=0, m=0; i<tree->num_nodes; i++) {
+                if (ynode_is_leaf(&tree->node[i])) {
+                        tree->leaf[k++] = i;
+                } else {
+                        tree->internal[m++] = i;
                 }
         }
 
-        tree->count        = n;
-        tree->num_leaves   = ynode_count_leaves(tree->root); 
-        tree->num_internal = ynode_count_internal(tree->root); 
-        tree->max_cost     = ynode_get_cost_max(tree->root, tree->data, n); 
-        tree->min_cost     = ynode_get_cost_min(tree->root, tree->data, n); 
+        ynode_cost_init(tree->root, tree->data);
+
+        ytree_cost_bounds(tree->data, n, &tree->max_cost, &tree->min_cost);
 
         return tree;
 }
@@ -46,52 +194,37 @@ struct ytree_t *ytree_create(int n, float **data)
  * TREE FREE 
  ******************************************************************************/
 
-/* 
- * This could be done much more efficiently, so
- * do that at some point.
- */
-struct ynode_t **Mem;
-int Mem_index;
-int Mem_max;
-
-void __impl__ytree_free(struct ynode_t *n, int i)
-{
-        if (n != NULL && Mem_index < Mem_max) {
-                Mem[Mem_index++] = n;
-        }
-}
-
 /**
  * ytree_free()
  * ------------ 
- * Remove a tree from memory.
+ * Free an entire tree structure.
  *
- * @tree : Pointer to tree structure.
+ * @tree : Pointer to a tree structure.
  * Return: Nothing.
  */
 void ytree_free(struct ytree_t *tree)
 {
-        int i;
-
-        Mem_max = tree->count + (tree->count-2);
-
-        Mem       = calloc(Mem_max, sizeof(struct ytree_t *));
-        Mem_index = 0;
-
-        ynode_traverse_preorder(tree->root, __impl__ytree_free);
+        if (tree == NULL) {
+                return;
+        }
 
-        for (i=0; i<Mem_index; i++) {
-                if (Mem[i] != NULL) {
-                        ynode_destroy(Mem[i]);
-                }
+        if (tree->node != NULL) {
+                free(tree->node);
         }
 
-        if (Mem != NULL) {
-                free(Mem);
+        if (tree->leaf != NULL) {
+                free(tree->leaf);
         }
-        if (tree != NULL) {
-                free(tree);
+        if (tree->internal != NULL) {
+                free(tree->internal);
         }
+
+        free(tree->enter);
+        free(tree->leave);
+
+        ytree_journal_free(tree->journal);
+
+        free(tree);
 }
 
 
@@ -99,25 +232,75 @@ void ytree_free(struct ytree_t *tree)
  * TREE COPY 
  ******************************************************************************/
 
-struct ynode_t *This_root;
-
-void __impl__ytree_copy(struct ynode_t *a, int i)
+/**
+ * ytree_copy_into()
+ * ----------------- 
+ * Overwrite one tree with a copy of another, re-using its node store.
+ *
+ * @dst  : Pointer to tree being overwritten.
+ * @src  : Pointer to tree being copied.
+ * Return: @dst, now identical to @src, or NULL. 
+ *
+ * NOTE
+ * The trees must have been created over the same number of 
+ * data points. Nothing is allocated: the node store is copied 
+ * wholesale, and each link is then moved by the distance 
+ * between the two stores.
+ */
+struct ytree_t *ytree_copy_into(struct ytree_t *dst, struct ytree_t *src)
 {
-        struct ynode_t *copy;
+        struct ynode_t *n;
+        int i;
+
+        if (dst == NULL || src == NULL) {
+                fprintf(stderr, "Cannot copy NULL tree\n");
+                return NULL;
+        }
+        if (dst->num_nodes != src->num_nodes) {
+                fprintf(stderr, "Cannot copy between trees of different size\n");
+                return NULL;
+        }
+        if (dst == src) {
+                return dst;
+        }
+
+        dst->data         = src->data;
+        dst->count        = src->count;
+        dst->num_leaves   = src->num_leaves; 
+        dst->num_internal = src->num_internal; 
+        dst->max_cost     = src->max_cost;
+        dst->min_cost     = src->min_cost;
+
+        /* Anything journalled refers to the old contents */
+        ytree_journal_commit(dst->journal);
 
-        if (a != NULL && !ynode_is_root(a)) {
-                copy = ynode_copy(a); 
+        memcpy(dst->node, src->node, src->num_nodes * sizeof(struct ynode_t));
+        memcpy(dst->leaf, src->leaf, src->num_leaves * sizeof(int));
+        memcpy(dst->internal, src->internal, src->num_internal * sizeof(int));
+        memcpy(dst->enter, src->enter, src->num_nodes * sizeof(int));
+        memcpy(dst->leave, src->leave, src->num_nodes * sizeof(int));
 
-                char *path = ynode_get_path(a);
+        /* The journal was just committed, so nothing is pending */
+        dst->tour_current = src->tour_current;
+        dst->tour_moved   = false;
 
-                ynode_insert_on_path(This_root, copy, path);
+        for (i=0; i<dst->num_nodes; i++) {
+                n = &dst->node[i];
 
-                if (path != NULL) {
-                        free(path);
+                if (n->L != NULL) {
+                        n->L = dst->node + (n->L - src->node);
+                }
+                if (n->R != NULL) {
+                        n->R = dst->node + (n->R - src->node);
+                }
+                if (n->P != NULL) {
+                        n->P = dst->node + (n->P - src->node);
                 }
         }
 
-        return;
+        dst->root = dst->node + (src->root - src->node);
+
+        return dst;
 }
 
 
@@ -131,27 +314,21 @@ void __impl__ytree_copy(struct ynode_t *a, int i)
  */
 struct ytree_t *ytree_copy(struct ytree_t *tree)
 {
+        struct ytree_t *copy;
+
         if (tree == NULL) {
                 fprintf(stderr, "Cannot copy NULL tree\n");
                 return NULL;
         }
 
-        struct ytree_t *copy;
-
         copy = calloc(1, sizeof(struct ytree_t));
 
-        copy->data         = tree->data;
-        copy->count        = tree->count;
-        copy->num_leaves   = tree->num_leaves; 
-        copy->num_internal = tree->num_internal; 
-        copy->max_cost     = tree->max_cost;
-        copy->min_cost     = tree->min_cost;
-
-        copy->root = ynode_copy(tree->root);
-
-        This_root = copy->root;
-
-        ynode_traverse_preorder(tree->root, __impl__ytree_copy);
+        copy->num_nodes = tree->num_nodes; 
+        copy->node      = malloc(tree->num_nodes * sizeof(struct ynode_t));
+        copy->leaf      = malloc(tree->num_leaves * sizeof(int));
+        copy->internal  = malloc(tree->num_internal * sizeof(int));
+        copy->enter     = malloc(tree->num_nodes * sizeof(int));
+        copy->leave     = malloc(tree->num_nodes * sizeof(int));
 
-        return copy;
+        return ytree_copy_into(copy, tree);
 }
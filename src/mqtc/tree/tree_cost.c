@@ -1,20 +1,11 @@
+#include <pthread.h>
+#include <unistd.h>
 #include "ytree.h"
 
 /******************************************************************************
  * TREE COST 
  ******************************************************************************/
 
-float **Cost_data; 
-float   Tree_cost; 
-
-void __impl__ytree_cost(struct ynode_t *n, int i)
-{
-        if (ynode_is_internal(n)) {
-                Tree_cost += ynode_get_cost(n, Cost_data);
-        }
-        return;
-}
-
 /**
  * ytree_cost()
  * ------------ 
@@ -22,15 +13,33 @@ void __impl__ytree_cost(struct ynode_t *n, int i)
  *
  * @tree : Pointer to a tree structure.
  * Return: Cost C(T) of the tree at @tree.
+ *
+ * NOTE
+ * The cost is kept current by the mutation operators in the 
+ * cached sums at each node (see node_cost.c), so the total 
+ * at the root is the cost of the whole tree.
  */
 float ytree_cost(struct ytree_t *tree)
 {
-        Cost_data = tree->data;
-        Tree_cost = 0;
+        return (float)tree->root->sum.total;
+}
 
-        ynode_traverse_preorder(tree->root, __impl__ytree_cost);
 
-        return Tree_cost;
+/**
+ * ytree_cost_full()
+ * ----------------- 
+ * Compute the un-normalized tree cost from scratch.
+ *
+ * @tree : Pointer to a tree structure.
+ * Return: Cost C(T) of the tree at @tree.
+ *
+ * NOTE
+ * Slower than ytree_cost(), at O(n^2), but it does not use
+ * the cached sums, so it can be used to check them. 
+ */
+float ytree_cost_full(struct ytree_t *tree)
+{
+        return (float)ynode_get_cost_total(tree->root, tree->data);
 }
 
 
@@ -47,3 +56,82 @@ float ytree_cost_scaled(struct ytree_t *tree)
         float Ct = ytree_cost(tree);
         return (tree->max_cost - Ct) / (tree->max_cost - tree->min_cost);
 }
+
+
+
+/******************************************************************************
+ * TREE COST BOUNDS 
+ ******************************************************************************/
+
+/* 
+ * Bounds of the last matrix asked about. Every tree built
+ * from that matrix shares them, so they are only computed 
+ * once, by whichever thread gets here first.
+ */
+static pthread_mutex_t   Bounds_lock = PTHREAD_MUTEX_INITIALIZER;
+static struct ymatrix_t *Bounds_data = NULL;
+static int               Bounds_n    = 0;
+static float             Bounds_max  = 0.0;
+static float             Bounds_min  = 0.0;
+
+
+/**
+ * ytree_cost_bounds()
+ * ------------------- 
+ * Find the maximum and minimum cost of any tree over a data matrix.
+ *
+ * @data : @nx@n data matrix.
+ * @n    : Number of data points
+ * @max  : Filled with the maximum cost M(T).
+ * @min  : Filled with the minimum cost m(T).
+ * Return: Nothing.
+ *
+ * NOTE
+ * The O(n^4) pass is shared between all online processors.
+ * Its result is kept for the matrix at @data, which must not 
+ * be changed while trees over it exist.
+ */
+void ytree_cost_bounds(struct ymatrix_t *data, int n, float *max, float *min)
+{
+        long cpus;
+
+        pthread_mutex_lock(&Bounds_lock);
+
+        if (Bounds_data != data || Bounds_n != n) {
+                cpus = sysconf(_SC_NPROCESSORS_ONLN);
+
+                ynode_get_cost_bounds(data, n, (cpus > 0) ? (int)cpus : 1, &Bounds_max, &Bounds_min);
+
+                Bounds_data = data;
+                Bounds_n    = n;
+        }
+
+        *max = Bounds_max;
+        *min = Bounds_min;
+
+        pthread_mutex_unlock(&Bounds_lock);
+}
+
+
+/**
+ * ytree_cost_bounds_set()
+ * ----------------------- 
+ * Supply known bounds for a data matrix, so they are not computed.
+ *
+ * @data : @nx@n data matrix.
+ * @n    : Number of data points
+ * @max  : Maximum cost M(T).
+ * @min  : Minimum cost m(T).
+ * Return: Nothing.
+ */
+void ytree_cost_bounds_set(struct ymatrix_t *data, int n, float max, float min)
+{
+        pthread_mutex_lock(&Bounds_lock);
+
+        Bounds_data = data;
+        Bounds_n    = n;
+        Bounds_max  = max;
+        Bounds_min  = min;
+
+        pthread_mutex_unlock(&Bounds_lock);
+}
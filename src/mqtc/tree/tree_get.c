@@ -0,0 +1,50 @@
+#include "ytree.h"
+
+/******************************************************************************
+ * TREE RANDOM NODES
+ ******************************************************************************/
+
+/**
+ * ytree_get_random()
+ * ------------------
+ * Select a node from the tree uniformly at random, excluding the root.
+ *
+ * @tree : Pointer to a tree structure.
+ * Return: Pointer to some (leaf or internal) node of @tree.
+ *
+ * NOTE
+ * The root is always the first entry of the node store,
+ * and no operator will accept it, so it is never picked.
+ */
+struct ynode_t *ytree_get_random(struct ytree_t *tree)
+{
+        return &tree->node[1 + dice_roll(tree->num_nodes - 1)];
+}
+
+
+/**
+ * ytree_get_random_leaf()
+ * -----------------------
+ * Select a leaf from the tree uniformly at random.
+ *
+ * @tree : Pointer to a tree structure.
+ * Return: Pointer to some leaf node of @tree.
+ */
+struct ynode_t *ytree_get_random_leaf(struct ytree_t *tree)
+{
+        return &tree->node[tree->leaf[dice_roll(tree->num_leaves)]];
+}
+
+
+/**
+ * ytree_get_random_internal()
+ * ---------------------------
+ * Select an internal node from the tree uniformly at random.
+ *
+ * @tree : Pointer to a tree structure.
+ * Return: Pointer to some internal node of @tree.
+ */
+struct ynode_t *ytree_get_random_internal(struct ytree_t *tree)
+{
+        return &tree->node[tree->internal[dice_roll(tree->num_internal)]];
+}
@@ -0,0 +1,152 @@
+#include "ytree.h"
+
+/******************************************************************************
+ * TREE JOURNAL
+ *
+ * A journal holds the prior contents of every node that a run of
+ * mutations is about to touch, so that a rejected proposal can be
+ * rolled back in place, instead of being made on a copy of the tree.
+ *
+ * Every mutation operator only changes its two arguments, their
+ * ancestors (links and cached sums), and the sibling of the first
+ * argument along with that sibling's children. Saving those before
+ * each operator runs is enough to put the tree back exactly.
+ ******************************************************************************/
+
+#define YJOURNAL_INITIAL_SIZE 64
+
+struct yentry_t {
+        struct ynode_t *at;     /* Node that was saved */
+        struct ynode_t  was;    /* Its contents at the time */
+};
+
+struct yjournal_t {
+        struct yentry_t *entry;
+        int              count;
+        int              max;
+};
+
+
+/**
+ * ytree_journal_create()
+ * ----------------------
+ * Allocate an empty journal.
+ *
+ * Return: Pointer to a journal.
+ */
+struct yjournal_t *ytree_journal_create(void)
+{
+        struct yjournal_t *j;
+
+        j = calloc(1, sizeof(struct yjournal_t));
+
+        j->max   = YJOURNAL_INITIAL_SIZE;
+        j->entry = calloc(j->max, sizeof(struct yentry_t));
+        j->count = 0;
+
+        return j;
+}
+
+
+/**
+ * ytree_journal_free()
+ * --------------------
+ * Free a journal.
+ *
+ * @j    : Pointer to a journal.
+ * Return: Nothing.
+ */
+void ytree_journal_free(struct yjournal_t *j)
+{
+        if (j != NULL) {
+                if (j->entry != NULL) {
+                        free(j->entry);
+                }
+                free(j);
+        }
+}
+
+
+/**
+ * ytree_journal_save()
+ * --------------------
+ * Save the contents of a node.
+ *
+ * @j    : Pointer to a journal.
+ * @n    : Node to save (may be NULL).
+ * Return: Nothing.
+ */
+void ytree_journal_save(struct yjournal_t *j, struct ynode_t *n)
+{
+        if (j == NULL || n == NULL) {
+                return;
+        }
+
+        if (j->count == j->max) {
+                j->max  *= 2;
+                j->entry = realloc(j->entry, j->max * sizeof(struct yentry_t));
+        }
+
+        j->entry[j->count].at  = n;
+        j->entry[j->count].was = *n;
+        j->count++;
+}
+
+
+/**
+ * ytree_journal_save_path()
+ * -------------------------
+ * Save the contents of a node and of each of its ancestors.
+ *
+ * @j    : Pointer to a journal.
+ * @n    : Node to start from (may be NULL).
+ * Return: Nothing.
+ */
+void ytree_journal_save_path(struct yjournal_t *j, struct ynode_t *n)
+{
+        while (n != NULL) {
+                ytree_journal_save(j, n);
+                n = n->P;
+        }
+}
+
+
+/**
+ * ytree_journal_rollback()
+ * ------------------------
+ * Restore every saved node, newest first, and empty the journal.
+ *
+ * @j    : Pointer to a journal.
+ * Return: Nothing.
+ *
+ * NOTE
+ * A node saved more than once ends up with the contents it
+ * had when it was first saved, i.e. before any of the edits.
+ */
+void ytree_journal_rollback(struct yjournal_t *j)
+{
+        if (j == NULL) {
+                return;
+        }
+
+        while (j->count > 0) {
+                j->count--;
+                *j->entry[j->count].at = j->entry[j->count].was;
+        }
+}
+
+
+/**
+ * ytree_journal_commit()
+ * ----------------------
+ * Keep the edits, and empty the journal.
+ *
+ * @j    : Pointer to a journal.
+ * Return: Nothing.
+ */
+void ytree_journal_commit(struct yjournal_t *j)
+{
+        if (j != NULL) {
+                j->count = 0;
+        }
+}
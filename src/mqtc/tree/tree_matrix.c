@@ -0,0 +1,282 @@
+#include "ytree.h"
+
+/******************************************************************************
+ * DISTANCE MATRIX
+ *
+ * The cost routines index the matrix in their innermost loops, so it is
+ * kept in one block, with rows a fixed stride apart, rather than behind
+ * a pointer per row. Index it with YDIST(), or take a row with YROW().
+ ******************************************************************************/
+
+/**
+ * ymatrix_create()
+ * ----------------
+ * Allocate a zeroed @nx@n distance matrix.
+ *
+ * @n    : Number of rows (and columns).
+ * Return: Pointer to a matrix, or NULL if out of memory.
+ *
+ * NOTE
+ * The stride is rounded up to a whole number of YMATRIX_ALIGN
+ * byte blocks, so that every row starts on such a boundary.
+ */
+struct ymatrix_t *ymatrix_create(int n)
+{
+        struct ymatrix_t *d;
+        size_t lanes = YMATRIX_ALIGN / sizeof(float);
+        size_t bytes;
+
+        if ((d = calloc(1, sizeof(struct ymatrix_t))) == NULL) {
+                return NULL;
+        }
+
+        d->n      = n;
+        d->stride = (int)(((size_t)n + lanes - 1) / lanes * lanes);
+
+        bytes   = (size_t)n * d->stride * sizeof(float);
+        d->cell = aligned_alloc(YMATRIX_ALIGN, (bytes > 0) ? bytes : YMATRIX_ALIGN);
+
+        if (d->cell == NULL) {
+                free(d);
+                return NULL;
+        }
+
+        memset(d->cell, 0, bytes);
+
+        return d;
+}
+
+
+/**
+ * ymatrix_wrap()
+ * --------------
+ * Describe a matrix held in memory that is not owned by the tree library.
+ *
+ * @cell  : First element of row 0.
+ * @n     : Number of rows (and columns).
+ * @stride: Elements from the start of one row to the next.
+ * Return: Pointer to a matrix, or NULL if out of memory.
+ *
+ * NOTE
+ * Used to work straight from a mapped matrix file. Only the
+ * matrix header is allocated; @cell must outlive it.
+ */
+struct ymatrix_t *ymatrix_wrap(float *cell, int n, int stride)
+{
+        struct ymatrix_t *d;
+
+        if ((d = calloc(1, sizeof(struct ymatrix_t))) == NULL) {
+                return NULL;
+        }
+
+        d->cell   = cell;
+        d->n      = n;
+        d->stride = stride;
+
+        return d;
+}
+
+
+/* Edge of the minimum spanning tree, for ymatrix_relabel() */
+struct __impl__yedge_t {
+        int   a;
+        int   b;
+        float w;
+};
+
+
+static int __impl__yedge_cmp(const void *x, const void *y)
+{
+        const struct __impl__yedge_t *e = x;
+        const struct __impl__yedge_t *f = y;
+
+        if (e->w != f->w) {
+                return (e->w < f->w) ? -1 : 1;
+        }
+
+        return (e->b - f->b);
+}
+
+
+/**
+ * ymatrix_relabel()
+ * -----------------
+ * Reorder the rows and columns so that close points are close in memory.
+ *
+ * @d    : Distance matrix, reordered in place.
+ * Return: Nothing.
+ *
+ * NOTE
+ * The cost of a node sums @d over the leaves on either side of
+ * it, and leaves that sit together in a good tree tend to be near
+ * each other in @d. Putting those rows side by side keeps those
+ * sums in a few cache lines, rather than spread over the matrix.
+ *
+ * The order is the leaf order of a single-linkage clustering,
+ * on d[i][j] + d[j][i]: the edges of a minimum spanning tree 
+ * (Prim, O(n^2)) are taken shortest first, and each joins the 
+ * lists of the two clusters it links.
+ *
+ * @d->label is set to the input index of each row, so trees
+ * built afterwards still print the input labels. Quartet costs
+ * don't depend on the labelling, so the cost bounds of @d are
+ * unchanged (up to float rounding).
+ */
+void ymatrix_relabel(struct ymatrix_t *d)
+{
+        struct __impl__yedge_t *edge;
+        float *best;
+        float *row;
+        float  w;
+        int   *from;
+        int   *done;
+        int   *head;
+        int   *tail;
+        int   *next;
+        int   *root;
+        int   *order;
+        int   *label;
+        int    n = d->n;
+        int    a;
+        int    b;
+        int    i;
+        int    j;
+        int    k;
+
+        if (n < 3) {
+                return;
+        }
+
+        edge  = calloc(n, sizeof(struct __impl__yedge_t));
+        best  = calloc(n, sizeof(float));
+        from  = calloc(n, sizeof(int));
+        done  = calloc(n, sizeof(int));
+        head  = calloc(n, sizeof(int));
+        tail  = calloc(n, sizeof(int));
+        next  = calloc(n, sizeof(int));
+        root  = calloc(n, sizeof(int));
+        label = calloc(n, sizeof(int));
+
+        if (!edge || !best || !from || !done || !head || !tail || !next || !root || !label) {
+                /* Leave @d as it was */
+                free(label);
+                goto out;
+        }
+
+        /*
+         * Prim's algorithm, from row 0. 
+         */
+        for (j=0; j<n; j++) {
+                best[j] = YDIST(d, 0, j) + YDIST(d, j, 0);
+        }
+
+        done[0] = 1;
+
+        for (k=0; k<n-1; k++) {
+                for (i=-1, j=0; j<n; j++) {
+                        if (!done[j] && (i == -1 || best[j] < best[i])) {
+                                i = j;
+                        }
+                }
+
+                edge[k].a = from[i];
+                edge[k].b = i;
+                edge[k].w = best[i];
+                done[i]   = 1;
+
+                for (j=0; j<n; j++) {
+                        w = YDIST(d, i, j) + YDIST(d, j, i);
+
+                        if (!done[j] && w < best[j]) {
+                                best[j] = w;
+                                from[j] = i;
+                        }
+                }
+        }
+
+        qsort(edge, n-1, sizeof(struct __impl__yedge_t), __impl__yedge_cmp);
+
+        /*
+         * Join the clusters, shortest edge first. Each cluster is 
+         * a list through @next, from @head to @tail, named by its
+         * @root; a cluster's root always names itself.
+         */
+        for (i=0; i<n; i++) {
+                head[i] = i;
+                tail[i] = i;
+                next[i] = -1;
+                root[i] = i;
+        }
+
+        for (k=0; k<n-1; k++) {
+                for (a=edge[k].a; root[a]!=a; a=root[a]);
+                for (b=edge[k].b; root[b]!=b; b=root[b]);
+
+                root[edge[k].a] = a;
+                root[edge[k].b] = a;
+                root[b]         = a;
+
+                next[tail[a]] = head[b];
+                tail[a]       = tail[b];
+        }
+
+        for (a=0; root[a]!=a; a=root[a]);
+
+        /* 
+         * Row k of the new matrix is row order[k] of the old, and
+         * likewise for the columns. The matrix may be too big to 
+         * copy, so it is permuted in place, through one row.
+         */
+        order = from;
+        row   = best;
+
+        for (k=0, i=head[a]; i!=-1; i=next[i]) {
+                order[k++] = i;
+        }
+
+        for (i=0; i<n; i++) {
+                label[i] = YLABEL(d, order[i]);
+        }
+
+        for (i=0; i<n; i++) {
+                for (j=0; j<n; j++) {
+                        row[j] = YDIST(d, i, order[j]);
+                }
+                memcpy(YROW(d, i), row, n * sizeof(float));
+        }
+
+        /* 
+         * The rows are moved along each cycle of @order; the row
+         * at the start of the cycle is held in @row meanwhile.
+         */
+        memset(done, 0, n * sizeof(int));
+
+        for (i=0; i<n; i++) {
+                if (done[i]) {
+                        continue;
+                }
+
+                memcpy(row, YROW(d, i), n * sizeof(float));
+
+                for (k=i; order[k]!=i; k=order[k]) {
+                        memcpy(YROW(d, k), YROW(d, order[k]), n * sizeof(float));
+                        done[k] = 1;
+                }
+
+                memcpy(YROW(d, k), row, n * sizeof(float));
+                done[k] = 1;
+        }
+
+        free(d->label);
+        d->label = label;
+
+out:
+        free(edge);
+        free(best);
+        free(from);
+        free(done);
+        free(head);
+        free(tail);
+        free(next);
+        free(root);
+}
@@ -1,9 +1,185 @@
 #include "ytree.h"
 
+/******************************************************************************
+ * TREE CHECK 
+ *
+ * Checking the whole shape of the tree after every primitive mutation 
+ * costs O(n) each time, and k can be as large as 5n-16. Instead, after 
+ * every run of mutations the leaf count kept at the root is compared 
+ * with the number of leaves, in O(1), and the full check is made:
+ *
+ *      YTREE_CHECK_NONE        never;
+ *      YTREE_CHECK_SAMPLED     after every YTREE_CHECK_INTERVAL-th run;
+ *      YTREE_CHECK_FULL        after every mutation, as it used to be.
+ *
+ * None of these draw random numbers, so a seeded run gives the same 
+ * tree whichever is used.
+ ******************************************************************************/
+
+#ifdef YTREE_CHECK_DEBUG
+static int Check_level = YTREE_CHECK_FULL;
+#else
+static int Check_level = YTREE_CHECK_SAMPLED;
+#endif
+
+
+/**
+ * ytree_check_set()
+ * ----------------- 
+ * Set how often the mutation operators check the trees they mutate.
+ *
+ * @level: YTREE_CHECK_NONE, YTREE_CHECK_SAMPLED or YTREE_CHECK_FULL.
+ * Return: Nothing.
+ *
+ * NOTE
+ * Call before any search starts. If YTREE_CHECK_DEBUG is 
+ * defined, this is ignored, and every mutation is checked.
+ */
+void ytree_check_set(int level)
+{
+        #ifndef YTREE_CHECK_DEBUG
+                Check_level = level;
+        #endif
+}
+
+
+/**
+ * ytree_check()
+ * ------------- 
+ * Check the shape of a whole tree, exiting if it is malformed.
+ *
+ * @tree : Pointer to a tree structure.
+ * Return: Nothing.
+ */
+void ytree_check(struct ytree_t *tree)
+{
+        if (!ynode_is_ternary(tree->root)) {
+                fprintf(stderr, "Malformed tree.\n");
+                exit(1);
+        }
+
+        if (tree->num_leaves != ynode_count_leaves(tree->root)) {
+                fprintf(stderr, "Malformed tree.\n");
+                exit(1);
+        }
+}
+
+
+static inline void __impl__ytree_check_step(struct ytree_t *tree)
+{
+        if (Check_level == YTREE_CHECK_FULL) {
+                ytree_check(tree);
+        }
+}
+
+
+static inline void __impl__ytree_check_batch(struct ytree_t *tree)
+{
+        if (tree->root->sum.count != tree->num_leaves) {
+                fprintf(stderr, "Malformed tree.\n");
+                exit(1);
+        }
+
+        if (Check_level == YTREE_CHECK_SAMPLED && ++tree->num_batches % YTREE_CHECK_INTERVAL == 0) {
+                ytree_check(tree);
+        }
+}
+
+
 /******************************************************************************
  * TREE MUTATE 
  ******************************************************************************/
 
+/**
+ * __impl__ytree_is_trivial()
+ * -------------------------- 
+ * Determine whether a subtree mutation of two nodes moves nothing.
+ *
+ * @a    : Pointer to node
+ * @b    : Pointer to node
+ * Return: 1 if the operators decline @a and @b, or only swap
+ *         the children of their parent, else 0.
+ *
+ * NOTE
+ * These cases are settled without asking whether @a and @b
+ * are disjoint, which is left to ytree_is_disjoint().
+ */
+static inline int __impl__ytree_is_trivial(struct ynode_t *a, struct ynode_t *b)
+{
+        return ynode_is_equal(a, b) || ynode_is_root(a) || ynode_is_root(b) || ynode_is_sibling(a, b);
+}
+
+
+/**
+ * __impl__ytree_mutate_step()
+ * --------------------------- 
+ * Apply one randomly chosen mutation, journalling the nodes it touches.
+ *
+ * @tree : Pointer to a tree structure.
+ * @j    : Journal to record into (NULL to not record).
+ * Return: Nothing.
+ */
+static void __impl__ytree_mutate_step(struct ytree_t *tree, struct yjournal_t *j)
+{
+        struct ynode_t *a;
+        struct ynode_t *b;
+        struct ynode_t *s;
+
+        switch (dice_roll(3)) {
+        case 0:
+                a = ytree_get_random_leaf(tree);
+                b = ytree_get_random_leaf(tree);
+
+                ytree_journal_save_path(j, a);
+                ytree_journal_save_path(j, b);
+
+                if (!ynode_is_equal(a, b) && !ynode_is_sibling(a, b)) {
+                        ytree_tour_moved(tree);
+                }
+
+                ynode_LEAF_INTERCHANGE(a, b, tree->data);
+                break;
+        case 1:
+                a = ytree_get_random(tree);
+                b = ytree_get_random(tree);
+
+                ytree_journal_save_path(j, a);
+                ytree_journal_save_path(j, b);
+
+                if (__impl__ytree_is_trivial(a, b)) {
+                        /* Declined, or the children of a->P swapped */
+                        ynode_SUBTREE_INTERCHANGE(a, b, tree->data);
+                } else if (ytree_is_disjoint(tree, a, b)) {
+                        ytree_tour_moved(tree);
+                        ynode_subtree_interchange(a, b, tree->data);
+                }
+                break;
+        case 2:
+                a = ytree_get_random(tree);
+                b = ytree_get_random(tree);
+
+                ytree_journal_save_path(j, a);
+                ytree_journal_save_path(j, b);
+
+                /* The sibling of a is promoted or re-used */
+                if ((s = ynode_get_sibling(a)) != NULL) {
+                        ytree_journal_save(j, s);
+                        ytree_journal_save(j, s->L);
+                        ytree_journal_save(j, s->R);
+                }
+
+                if (__impl__ytree_is_trivial(a, b)) {
+                        ynode_SUBTREE_TRANSFER(a, b, tree->data);
+                } else if (ytree_is_disjoint(tree, a, b)) {
+                        ytree_tour_moved(tree);
+                        ynode_subtree_transfer(a, b, tree->data);
+                }
+                break;
+        }
+}
+
+
+
 /**
  * ytree_mutate()
  * -------------- 
@@ -14,9 +190,6 @@
  */
 int ytree_mutate(struct ytree_t *tree, struct alias_t *alias)
 {
-        struct ynode_t *a;
-        struct ynode_t *b;
-        int r;
         int m;
         int i;
 
@@ -24,37 +197,14 @@ int ytree_mutate(struct ytree_t *tree, struct alias_t *alias)
 
         for (i=0; i<m; i++) {
 
-                r = dice_roll(3);
-
-                switch (r) {
-                case 0:
-                        a = ynode_get_random_leaf(tree->root);
-                        b = ynode_get_random_leaf(tree->root);
-                        ynode_LEAF_INTERCHANGE(a, b);
-                        break;
-                case 1:
-                        a = ynode_get_random(tree->root);
-                        b = ynode_get_random(tree->root);
-                        ynode_SUBTREE_INTERCHANGE(a, b);
-                        break;
-                case 2:
-                        a = ynode_get_random(tree->root);
-                        b = ynode_get_random(tree->root);
-                        ynode_SUBTREE_TRANSFER(a, b);
-                        break;
-                }
-
-                if (!ynode_is_ternary(tree->root)) {
-                        fprintf(stderr, "Malformed tree.\n");
-                        exit(1);
-                }
+                __impl__ytree_mutate_step(tree, NULL);
+                ytree_tour_commit(tree);
 
-                if (tree->num_leaves != ynode_count_leaves(tree->root)) {
-                        fprintf(stderr, "Malformed tree.\n");
-                        exit(1);
-                }
+                __impl__ytree_check_step(tree);
         }
 
+        __impl__ytree_check_batch(tree);
+
         return m;
 }
 
@@ -66,85 +216,47 @@ int ytree_mutate(struct ytree_t *tree, struct alias_t *alias)
  *
  * @tree : Pointer to a tree structure.
  * Return: Number of mutations made
+ *
+ * NOTE
+ * Each mutation is accepted or rolled back on its own. 
  */
 int ytree_mutate_mmc(struct ytree_t *tree, struct alias_t *alias)
 {
-        struct ynode_t *a;
-        struct ynode_t *b;
         float cost;
         float best;
-        int r;
         int m;
         int i;
 
+        if (tree->journal == NULL) {
+                tree->journal = ytree_journal_create();
+        }
+
         m = alias_sample(alias)+1;
 
         best = ytree_cost(tree);
 
         for (i=0; i<m; i++) {
 
-                r = dice_roll(3);
-
-                switch (r) {
-                case 0:
-                        a = ynode_get_random_leaf(tree->root);
-                        b = ynode_get_random_leaf(tree->root);
-                        ynode_LEAF_INTERCHANGE(a, b);
-
-                        /* Check cost and undo if bad step */
-                        cost = ytree_cost(tree);
-
-                        if (prng_uniform_random() < min_float(2, 1.0, cost/best)) {
-                        /*if (cost > best) {*/
-                                best = cost;
-                        } else {
-                                /* Undo mutation */
-                                ynode_LEAF_INTERCHANGE(b, a);
-                        }
-                        break;
-                case 1:
-                        a = ynode_get_random(tree->root);
-                        b = ynode_get_random(tree->root);
-                        ynode_SUBTREE_INTERCHANGE(a, b);
-
-                        /* Check cost and undo if bad step */
-                        cost = ytree_cost(tree);
-                        /*if (cost > best) {*/
-                        if (prng_uniform_random() < min_float(2, 1.0, cost/best)) {
-                                best = cost;
-                        } else {
-                                /* Undo mutation */
-                                ynode_SUBTREE_INTERCHANGE(b, a);
-                        }
-                        break;
-                case 2:
-                        a = ynode_get_random(tree->root);
-                        b = ynode_get_random(tree->root);
-                        ynode_SUBTREE_TRANSFER(a, b);
-
-                        /* Check cost and undo if bad step */
-                        cost = ytree_cost(tree);
-                        /*if (cost > best) {*/
-                        if (prng_uniform_random() < min_float(2, 1.0, cost/best)) {
-                                best = cost;
-                        } else {
-                                /* Undo mutation */
-                                ynode_SUBTREE_INTERCHANGE(b, a);
-                        }
-                        break;
-                }
+                __impl__ytree_mutate_step(tree, tree->journal);
 
-                if (!ynode_is_ternary(tree->root)) {
-                        fprintf(stderr, "Malformed tree.\n");
-                        exit(1);
-                }
+                /* Check cost and undo if bad step */
+                cost = ytree_cost(tree);
 
-                if (tree->num_leaves != ynode_count_leaves(tree->root)) {
-                        fprintf(stderr, "Malformed tree.\n");
-                        exit(1);
+                if (prng_uniform_random() < min_float(2, 1.0, cost/best)) {
+                        best = cost;
+                        ytree_journal_commit(tree->journal);
+                        ytree_tour_commit(tree);
+                } else {
+                        /* Undo mutation */
+                        ytree_journal_rollback(tree->journal);
+                        ytree_tour_rollback(tree);
                 }
+
+                __impl__ytree_check_step(tree);
         }
 
+        __impl__ytree_check_batch(tree);
+
         return m;
 }
         
@@ -156,19 +268,25 @@ int ytree_mutate_mmc(struct ytree_t *tree, struct alias_t *alias)
  * Perform various mutations on a tree structure, preserving shape invariants.
  *
  * @tree : Pointer to a tree structure.
- * Return: Number of mutations made
+ * @alias: Distribution of k.
+ * @num_mutations: Filled with k, if not NULL.
+ * Return: @tree, mutated or as it was.
+ *
+ * NOTE
+ * The k mutations are made in place and journalled, so a
+ * rejected proposal is rolled back rather than the tree 
+ * being copied up front and the loser freed.
  */
 struct ytree_t *ytree_mutate_mmc2(struct ytree_t *tree, struct alias_t *alias, int *num_mutations)
 {
-        struct ynode_t *a;
-        struct ynode_t *b;
         float cost;
         float init;
-        int r;
         int m;
         int i;
 
-        struct ytree_t *test;
+        if (tree->journal == NULL) {
+                tree->journal = ytree_journal_create();
+        }
 
         m = alias_sample(alias)+1;
 
@@ -177,91 +295,83 @@ struct ytree_t *ytree_mutate_mmc2(struct ytree_t *tree, struct alias_t *alias, i
         }
 
         init = ytree_cost(tree);
-        test = ytree_copy(tree);
 
         for (i=0; i<m; i++) {
 
-                r = dice_roll(3);
-
-                switch (r) {
-                case 0:
-                        a = ynode_get_random_leaf(test->root);
-                        b = ynode_get_random_leaf(test->root);
-                        ynode_LEAF_INTERCHANGE(a, b);
-
-                        /* Check cost and undo if bad step */
-                        /*cost = tt_tree_cost(test);*/
-
-                        /*if (uniform_random() < min_float(2, 1.0, cost/running)) {*/
-                        /*[>[>if (cost > best) {<]<]*/
-                                /*[>best = cost;<]*/
-                                /*running = cost;*/
-                        /*} else {*/
-                                /*[>[> Undo mutation <]<]*/
-                                /*tt_LEAF_INTERCHANGE(b, a);*/
-                        /*}*/
-                        break;
-                case 1:
-                        a = ynode_get_random(test->root);
-                        b = ynode_get_random(test->root);
-                        ynode_SUBTREE_INTERCHANGE(a, b);
-
-                        /* Check cost and undo if bad step */
-                        /*cost = tt_tree_cost(test);*/
-                        /*[>[>if (cost > best) {<]<]*/
-                        /*if (uniform_random() < min_float(2, 1.0, cost/running)) {*/
-                                /*[>best = cost;<]*/
-                                /*running = cost;*/
-                        /*} else {*/
-                                /*[>[> Undo mutation <]<]*/
-                                /*tt_SUBTREE_INTERCHANGE(b, a);*/
-                        /*}*/
-                        break;
-                case 2:
-                        a = ynode_get_random(test->root);
-                        b = ynode_get_random(test->root);
-                        ynode_SUBTREE_TRANSFER(a, b);
-
-                        /* Check cost and undo if bad step */
-                        /*cost = tt_tree_cost(test);*/
-                        /*[>[>if (cost > best) {<]<]*/
-                        /*if (uniform_random() < min_float(2, 1.0, cost/running)) {*/
-                                /*[>best = cost;<]*/
-                                /*running = cost;*/
-                        /*} else {*/
-                                /*[>[> Undo mutation <]<]*/
-                                /*tt_SUBTREE_INTERCHANGE(b, a);*/
-                        /*}*/
-                        break;
-                }
-
-                if (!ynode_is_ternary(test->root)) {
-                        fprintf(stderr, "Malformed tree.\n");
-                        exit(1);
-                }
+                __impl__ytree_mutate_step(tree, tree->journal);
 
-                if (test->num_leaves != ynode_count_leaves(test->root)) {
-                        fprintf(stderr, "Malformed tree.\n");
-                        exit(1);
-                }
+                __impl__ytree_check_step(tree);
         }
 
-        cost = ytree_cost(test);
-
-        /*printf("cost(%f)/init(%f):%f\n", cost, init, cost/init);*/
+        cost = ytree_cost(tree);
 
-        /*if (cost > init) {*/
-                /*ytree_free(tree);*/
-                /*return test;*/
         if (prng_uniform_random() < 1.0 - (cost/init)) {
-        /*if (uniform_random() < 1.0-(cost/init)) {*/
-                ytree_free(tree);
-                return test;
+                ytree_journal_commit(tree->journal);
+                ytree_tour_commit(tree);
         } else {
-                ytree_free(test);
-                return tree;
+                ytree_journal_rollback(tree->journal);
+                ytree_tour_rollback(tree);
         }
+
+        __impl__ytree_check_batch(tree);
+
+        return tree;
 }
 
 
+/**
+ * ytree_mutate_temp()
+ * ------------------- 
+ * Propose a k-mutation and accept it by the Metropolis rule at a temperature.
+ *
+ * @tree : Pointer to a tree structure.
+ * @alias: Distribution of k.
+ * @temp : Temperature of the chain (> 0).
+ * @num_mutations: Filled with k, if not NULL.
+ * Return: @tree, mutated or as it was.
+ *
+ * NOTE
+ * Improvements in the scaled cost S(T) are always accepted,
+ * and a loss of x is accepted with probability exp(-x/@temp),
+ * so hot chains wander and cold chains climb. 
+ */
+struct ytree_t *ytree_mutate_temp(struct ytree_t *tree, struct alias_t *alias, float temp, int *num_mutations)
+{
+        float cost;
+        float init;
+        int m;
+        int i;
+
+        if (tree->journal == NULL) {
+                tree->journal = ytree_journal_create();
+        }
+
+        m = alias_sample(alias)+1;
 
+        if (num_mutations != NULL) {
+                *num_mutations = m;
+        }
+
+        init = ytree_cost_scaled(tree);
+
+        for (i=0; i<m; i++) {
+
+                __impl__ytree_mutate_step(tree, tree->journal);
+
+                __impl__ytree_check_step(tree);
+        }
+
+        cost = ytree_cost_scaled(tree);
+
+        if (cost >= init || prng_uniform_random() < expf((cost - init) / temp)) {
+                ytree_journal_commit(tree->journal);
+                ytree_tour_commit(tree);
+        } else {
+                ytree_journal_rollback(tree->journal);
+                ytree_tour_rollback(tree);
+        }
+
+        __impl__ytree_check_batch(tree);
+
+        return tree;
+}
@@ -0,0 +1,154 @@
+#include "ytree.h"
+
+/******************************************************************************
+ * TREE TOUR
+ *
+ * An Euler tour numbers each node when the tour enters it and again when
+ * it leaves, so that a is under b exactly when b's interval contains a's.
+ * That answers the ancestor and disjointness questions asked before each
+ * mutation in O(1), where walking parent pointers is O(depth), and the 
+ * trees the search passes through are often deep.
+ *
+ * The numbers go stale as soon as a mutation moves a subtree, so they are
+ * only trusted while the links are still those they were taken from:
+ *
+ *      - the first query after a commit renumbers the tree, in O(n);
+ *      - once a run of mutations has moved something, queries fall back
+ *        to walking, until the run is committed or rolled back;
+ *      - a rollback puts back the links the numbers were taken from.
+ *
+ * Swapping the children of a node leaves the answers unchanged, so it 
+ * does not count as moving anything.
+ ******************************************************************************/
+
+#define SLOT(tree, n) ((n) - (tree)->node)
+
+
+/**
+ * ytree_tour_refresh()
+ * -------------------- 
+ * Number the nodes of a tree in the order of an Euler tour.
+ *
+ * @tree : Pointer to a tree structure.
+ * Return: Nothing.
+ *
+ * NOTE
+ * Walks the parent pointers rather than a stack, so nothing 
+ * is allocated, however deep the tree is.
+ */
+void ytree_tour_refresh(struct ytree_t *tree)
+{
+        struct ynode_t *n;
+        struct ynode_t *prev = NULL;
+        struct ynode_t *next;
+        int t = 0;
+
+        for (n = tree->root; n != NULL; prev = n, n = next) {
+                if (prev == n->P) {
+                        /* Arrived from above */
+                        tree->enter[SLOT(tree, n)] = t++;
+                        next = (n->L != NULL) ? n->L : (n->R != NULL) ? n->R : n->P;
+                } else if (prev == n->L && n->R != NULL) {
+                        /* Back from the left; go right */
+                        next = n->R;
+                } else {
+                        next = n->P;
+                }
+
+                if (next == n->P) {
+                        tree->leave[SLOT(tree, n)] = t++;
+                }
+        }
+
+        tree->tour_current = true;
+}
+
+
+/**
+ * ytree_is_subtree_of()
+ * --------------------- 
+ * Determine whether a node is under another (or is the same node).
+ *
+ * @tree : Pointer to the tree holding @a and @b.
+ * @a    : Node to be checked
+ * @b    : Node to be checked
+ * Return: 1 (TRUE), or 0 (FALSE)
+ */
+int ytree_is_subtree_of(struct ytree_t *tree, struct ynode_t *a, struct ynode_t *b)
+{
+        if (!tree->tour_current && !tree->tour_moved) {
+                ytree_tour_refresh(tree);
+        }
+
+        if (!tree->tour_current) {
+                return ynode_is_equal(a, b) || ynode_is_subtree_of(a, b);
+        }
+
+        return tree->enter[SLOT(tree, b)] <= tree->enter[SLOT(tree, a)]
+            && tree->leave[SLOT(tree, a)] <= tree->leave[SLOT(tree, b)];
+}
+
+
+/**
+ * ytree_is_disjoint()
+ * ------------------- 
+ * Determine whether two nodes are disjoint. 
+ *
+ * @tree : Pointer to the tree holding @a and @b.
+ * @a    : Node to be checked
+ * @b    : Node to be checked
+ * Return: 1 (TRUE), or 0 (FALSE)
+ */
+int ytree_is_disjoint(struct ytree_t *tree, struct ynode_t *a, struct ynode_t *b)
+{
+        return (!ytree_is_subtree_of(tree, a, b) && !ytree_is_subtree_of(tree, b, a));
+}
+
+
+/**
+ * ytree_tour_moved()
+ * ------------------ 
+ * Note that a subtree of a tree has been moved.
+ *
+ * @tree : Pointer to a tree structure.
+ * Return: Nothing.
+ */
+void ytree_tour_moved(struct ytree_t *tree)
+{
+        if (!tree->tour_moved) {
+                tree->tour_saved = tree->tour_current;
+                tree->tour_moved = true;
+        }
+        tree->tour_current = false;
+}
+
+
+/**
+ * ytree_tour_commit()
+ * ------------------- 
+ * Keep the moves made since the last commit or rollback.
+ *
+ * @tree : Pointer to a tree structure.
+ * Return: Nothing.
+ */
+void ytree_tour_commit(struct ytree_t *tree)
+{
+        tree->tour_moved = false;
+}
+
+
+/**
+ * ytree_tour_rollback()
+ * --------------------- 
+ * Undo the moves made since the last commit (with the journal).
+ *
+ * @tree : Pointer to a tree structure.
+ * Return: Nothing.
+ */
+void ytree_tour_rollback(struct ytree_t *tree)
+{
+        if (tree->tour_moved) {
+                tree->tour_current = tree->tour_saved;
+                tree->tour_moved   = false;
+        }
+}
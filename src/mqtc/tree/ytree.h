@@ -24,7 +24,18 @@ extern int DATA_COUNT;
 #define YTREE_RANDOM_INSERT 
 
 /* Label of internal nodes (should be disjoint from input alphabet) */
-#define YTREE_INTERNAL_NODE_LABEL '.'
+#define YTREE_INTERNAL_NODE_LABEL -1
+
+/* Define this to check the whole tree after every mutation */
+/*#define YTREE_CHECK_DEBUG*/
+
+/* How often the mutation operators check the tree (see tree_mutate.c) */
+#define YTREE_CHECK_NONE     0
+#define YTREE_CHECK_SAMPLED  1
+#define YTREE_CHECK_FULL     2
+
+/* Runs of mutations between full checks, for YTREE_CHECK_SAMPLED */
+#define YTREE_CHECK_INTERVAL 64
 
 /******************************************************************************
  * DATA TYPES 
@@ -34,6 +45,42 @@ typedef int      ynode_value_t;    /* Node label value */
 typedef uint32_t ynode_ident_t;    /* Node ident value */
 
 
+/* 
+ * Partition sums cached at each node, so that the cost of the
+ * tree can be kept current as it is mutated. See node_cost.c.
+ */
+struct ycost_t {
+        int             count;    /* Leaves under this node */
+        double          within;   /* Sum of d[x][y], x,y under this node */
+        double          column;   /* Sum of d[*][x], x under this node */
+        double          cross_LR; /* Sum of d[x][y], x under L, y under R */
+        double          cross_RL; /* Sum of d[x][y], x under R, y under L */
+        double          total;    /* Sum of node costs under this node */
+};
+
+
+/*
+ * Distance matrix, in one aligned block. Each row starts @stride 
+ * floats after the one before it, so that every row is aligned 
+ * too; the padding at the end of a row is never read.
+ */
+struct ymatrix_t {
+        float          *cell;
+        int             n;
+        int             stride;
+        int            *label;  /* Input index of each row, or NULL */
+};
+
+#define YMATRIX_ALIGN 64
+
+/* Row @i of a matrix, and the distance from @i to @j */
+#define YROW(d, i)     (&(d)->cell[(size_t)(i) * (d)->stride])
+#define YDIST(d, i, j) ((d)->cell[(size_t)(i) * (d)->stride + (j)])
+
+/* Input index of row @i, which is what gets printed */
+#define YLABEL(d, i)   (((d)->label != NULL) ? (d)->label[i] : (i))
+
+
 /* Represents a node in the tree. */
 struct ynode_t {
         struct ynode_t *L;      
@@ -42,24 +89,39 @@ struct ynode_t {
         ynode_ident_t   id;
         ynode_value_t   value;
         ynode_value_t   key;
+        struct ycost_t  sum;
 };
 
 
 /* Handle for an entire tree */
 struct ytree_t {
         ynode_ident_t   count;
-        float         **data;
+        struct ymatrix_t *data;         /* Distance matrix (shared) */
         int             num_leaves;
         int             num_internal;
         float           max_cost;
         float           min_cost;
         struct ynode_t *root;
-        struct ynode_t **memory;
+        struct ynode_t *node;           /* Node store, root first */
+        int             num_nodes;      /* Entries in the node store */
+        int            *leaf;           /* Store index of each leaf */
+        int            *internal;       /* Store index of each internal node */
+        struct yjournal_t *journal;     /* Undo journal (see tree_journal.c) */
+        int            *enter;          /* Euler tour entry of each slot */
+        int            *leave;          /* Euler tour exit of each slot */
+        bool            tour_current;   /* enter/leave match the links */
+        bool            tour_moved;     /* Subtrees moved since last commit */
+        bool            tour_saved;     /* tour_current before they moved */
+        unsigned        num_batches;    /* Runs of mutations made */
 };
 
 
+/* Undo journal for a run of mutations (opaque). */
+struct yjournal_t;
+
+
 /* Function pointer used in traversal methods. */
-typedef void (*ynode_traverse_cb)(struct ynode_t *n, int i);
+typedef void (*ynode_traverse_cb)(struct ynode_t *n, int i, void *arg);
 
 /* Function pointer used in distance methods. */
 typedef void (*ynode_distance_cb)(struct ynode_t *a, struct ynode_t *b);
@@ -76,6 +138,7 @@ typedef void (*ynode_distance_cb)(struct ynode_t *a, struct ynode_t *b);
 /******************************************************************************
  * ALLOCATION node_alloc.c
  ******************************************************************************/
+struct ynode_t *ynode_init               (struct ynode_t *n, ynode_value_t value, ynode_value_t key);
 struct ynode_t *ynode_create             (ynode_value_t value, ynode_value_t key);
 struct ynode_t *ynode_create_root        (void);
 struct ynode_t *ynode_copy               (struct ynode_t *a);
@@ -89,6 +152,7 @@ struct ynode_t *ynode_add_right          (struct ynode_t *a, ynode_value_t value
 struct ynode_t *ynode_add_left_level     (struct ynode_t *a, ynode_value_t value, ynode_value_t key);
 struct ynode_t *ynode_add_right_level    (struct ynode_t *a, ynode_value_t value, ynode_value_t key);
 struct ynode_t *ynode_add_before         (struct ynode_t *a, ynode_value_t value, ynode_value_t key);
+struct ynode_t *ynode_link_before        (struct ynode_t *a, struct ynode_t *n);
 struct ynode_t *ynode_insert             (struct ynode_t *a, ynode_value_t value, ynode_value_t key);
 void            ynode_insert_on_path     (struct ynode_t *r, struct ynode_t *a, char *path);
 
@@ -100,26 +164,33 @@ struct ynode_t *ynode_get_random_leaf    (struct ynode_t *n);
 struct ynode_t *ynode_get_random_internal(struct ynode_t *n);
 struct ynode_t *ynode_get_sibling        (struct ynode_t *n);
 struct ynode_t *ynode_get_root           (struct ynode_t *n);
-char           *ynode_get_path           (struct ynode_t *n);
-ynode_value_t  *ynode_get_values         (struct ynode_t *n);
-ynode_value_t  *ynode_get_values_not     (struct ynode_t *n, struct ynode_t *x);
 
 /******************************************************************************
  * MUTATIONS node_mutate.c
  ******************************************************************************/
 struct ynode_t *ynode_contract           (struct ynode_t *n);
 struct ynode_t *ynode_promote            (struct ynode_t *n);
-void            ynode_LEAF_INTERCHANGE   (struct ynode_t *a, struct ynode_t *b);
-void            ynode_SUBTREE_INTERCHANGE(struct ynode_t *a, struct ynode_t *b);
-void            ynode_SUBTREE_TRANSFER   (struct ynode_t *a, struct ynode_t *b);
+struct ynode_t *ynode_detach             (struct ynode_t *n, struct ymatrix_t *d);
+void            ynode_attach             (struct ynode_t *p, struct ynode_t *n, struct ymatrix_t *d);
+void            ynode_subtree_interchange(struct ynode_t *a, struct ynode_t *b, struct ymatrix_t *d);
+void            ynode_subtree_transfer   (struct ynode_t *a, struct ynode_t *b, struct ymatrix_t *d);
+void            ynode_LEAF_INTERCHANGE   (struct ynode_t *a, struct ynode_t *b, struct ymatrix_t *d);
+void            ynode_SUBTREE_INTERCHANGE(struct ynode_t *a, struct ynode_t *b, struct ymatrix_t *d);
+void            ynode_SUBTREE_TRANSFER   (struct ynode_t *a, struct ynode_t *b, struct ymatrix_t *d);
 
 /******************************************************************************
  * COST node_cost.c
  ******************************************************************************/
-float           ynode_get_cost           (struct ynode_t *n, float **distance);
-float           ynode_get_cost_max       (struct ynode_t *a, float **d, int n);
-float           ynode_get_cost_min       (struct ynode_t *a, float **d, int n);
+float           ynode_get_cost           (struct ynode_t *n, struct ymatrix_t *distance);
+double          ynode_get_cost_total     (struct ynode_t *n, struct ymatrix_t *d);
+float           ynode_get_cost_max       (struct ynode_t *a, struct ymatrix_t *d, int n);
+float           ynode_get_cost_min       (struct ynode_t *a, struct ymatrix_t *d, int n);
+void            ynode_get_cost_bounds    (struct ymatrix_t *d, int n, int threads, float *max, float *min);
 float           ynode_get_cost_scaled    (float c, float M, float m);
+void            ynode_cost_init          (struct ynode_t *n, struct ymatrix_t *d);
+void            ynode_cost_update        (struct ynode_t *n);
+void            ynode_cost_remove        (struct ynode_t *p, struct ynode_t *n, struct ymatrix_t *d);
+void            ynode_cost_insert        (struct ynode_t *p, struct ynode_t *n, struct ymatrix_t *d);
 
 /******************************************************************************
  * COUNTING node_count.c
@@ -131,9 +202,9 @@ int             ynode_count_internal     (struct ynode_t *a);
 /******************************************************************************
  * TRAVERSAL node_traverse.c
  ******************************************************************************/
-void            ynode_traverse_inorder   (struct ynode_t *a, ynode_traverse_cb visit);
-void            ynode_traverse_preorder  (struct ynode_t *a, ynode_traverse_cb visit);
-void            ynode_traverse_postorder (struct ynode_t *a, ynode_traverse_cb visit);
+void            ynode_traverse_inorder   (struct ynode_t *a, ynode_traverse_cb visit, void *arg);
+void            ynode_traverse_preorder  (struct ynode_t *a, ynode_traverse_cb visit, void *arg);
+void            ynode_traverse_postorder (struct ynode_t *a, ynode_traverse_cb visit, void *arg);
 
 /******************************************************************************
  * PREDICATES node_check.c
@@ -164,18 +235,56 @@ void            ynode_print              (struct ynode_t *n, const char *fmt);
 /* ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
 
 
+/******************************************************************************
+ * DISTANCE MATRIX tree_matrix.c
+ ******************************************************************************/
+struct ymatrix_t *ymatrix_create         (int n);
+struct ymatrix_t *ymatrix_wrap           (float *cell, int n, int stride);
+void              ymatrix_relabel        (struct ymatrix_t *d);
+
 /******************************************************************************
  * TREE ALLOCATION 
  ******************************************************************************/
-struct ytree_t *ytree_create             (int n, float **data);
+struct ytree_t *ytree_create             (int n, struct ymatrix_t *data);
 void            ytree_free               (struct ytree_t *tree);
 struct ytree_t *ytree_copy               (struct ytree_t *tree);
+struct ytree_t *ytree_copy_into          (struct ytree_t *dst, struct ytree_t *src);
+
+/******************************************************************************
+ * TREE SELECTION 
+ ******************************************************************************/
+struct ynode_t *ytree_get_random         (struct ytree_t *tree);
+struct ynode_t *ytree_get_random_leaf    (struct ytree_t *tree);
+struct ynode_t *ytree_get_random_internal(struct ytree_t *tree);
+
+/******************************************************************************
+ * TREE JOURNAL 
+ ******************************************************************************/
+struct yjournal_t *ytree_journal_create  (void);
+void            ytree_journal_free       (struct yjournal_t *j);
+void            ytree_journal_save       (struct yjournal_t *j, struct ynode_t *n);
+void            ytree_journal_save_path  (struct yjournal_t *j, struct ynode_t *n);
+void            ytree_journal_rollback   (struct yjournal_t *j);
+void            ytree_journal_commit     (struct yjournal_t *j);
+
+/******************************************************************************
+ * TREE TOUR 
+ ******************************************************************************/
+void            ytree_tour_refresh       (struct ytree_t *tree);
+int             ytree_is_subtree_of      (struct ytree_t *tree, struct ynode_t *a, struct ynode_t *b);
+int             ytree_is_disjoint        (struct ytree_t *tree, struct ynode_t *a, struct ynode_t *b);
+void            ytree_tour_moved         (struct ytree_t *tree);
+void            ytree_tour_commit        (struct ytree_t *tree);
+void            ytree_tour_rollback      (struct ytree_t *tree);
 
 /******************************************************************************
  * TREE QTC 
  ******************************************************************************/
 float           ytree_cost               (struct ytree_t *tree);
 float           ytree_cost_scaled        (struct ytree_t *tree);
+float           ytree_cost_full          (struct ytree_t *tree);
+void            ytree_cost_bounds        (struct ymatrix_t *data, int n, float *max, float *min);
+void            ytree_cost_bounds_set    (struct ymatrix_t *data, int n, float max, float min);
 
 /******************************************************************************
  * TREE MUTATIONS 
@@ -183,6 +292,9 @@ float           ytree_cost_scaled        (struct ytree_t *tree);
 int             ytree_mutate             (struct ytree_t *tree, struct alias_t *alias);
 int             ytree_mutate_mmc         (struct ytree_t *tree, struct alias_t *alias);
 struct ytree_t *ytree_mutate_mmc2        (struct ytree_t *tree, struct alias_t *alias, int *num_mutations);
+struct ytree_t *ytree_mutate_temp        (struct ytree_t *tree, struct alias_t *alias, float temp, int *num_mutations);
+void            ytree_check_set          (int level);
+void            ytree_check              (struct ytree_t *tree);
 
 
 #endif
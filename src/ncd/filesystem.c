@@ -1,6 +1,8 @@
 #include <stdlib.h>
 #include <stdio.h>
 #include <string.h>
+#include <fcntl.h>
+#include <sys/mman.h>
 #include "filesystem.h"
 
 void directory_scan(char *path, struct directory_t *data)
@@ -30,6 +32,10 @@ void directory_scan(char *path, struct directory_t *data)
 
         pathlen = strlen(data->path); /* Updated depending on adding '/' */
 
+        /* Contents are only read in by directory_load() */
+        data->file_data = NULL;
+        data->file_size = NULL;
+
         /* Open the directory */
         directory = opendir(path);
 
@@ -76,6 +82,97 @@ void directory_scan(char *path, struct directory_t *data)
 }
 
 
+/**
+ * directory_load
+ * ``````````````
+ * Map the contents of every file in a scanned directory into memory.
+ *
+ * @data : directory, filled in by directory_scan()
+ * Return: 0 on success, -1 if a file could not be read.
+ *
+ * NOTE
+ * Each file is opened exactly once, and its descriptor closed
+ * again as soon as it is mapped, so a corpus of any size never
+ * holds more than one descriptor open. Empty files have NULL 
+ * data and size 0.
+ */
+int directory_load(struct directory_t *data)
+{
+        struct stat st;
+        void *map;
+        int fd;
+        int i;
+
+        data->file_data = calloc(data->file_count, sizeof(unsigned char *));
+        data->file_size = calloc(data->file_count, sizeof(size_t));
+
+        for (i=0; i<data->file_count; i++) {
+
+                if ((fd = open(data->file_path[i], O_RDONLY)) < 0) {
+                        goto fail;
+                }
+
+                if (fstat(fd, &st) < 0) {
+                        close(fd);
+                        goto fail;
+                }
+
+                data->file_size[i] = (size_t)st.st_size;
+
+                if (st.st_size > 0) {
+                        map = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+
+                        if (map == MAP_FAILED) {
+                                data->file_size[i] = 0;
+                                close(fd);
+                                goto fail;
+                        }
+
+                        data->file_data[i] = map;
+                }
+
+                close(fd);
+        }
+
+        return 0;
+
+fail:
+        fprintf(stderr, "Could not read %s\n", data->file_path[i]);
+        directory_unload(data);
+        return -1;
+}
+
+
+/**
+ * directory_unload
+ * ````````````````
+ * Release the contents mapped by directory_load().
+ *
+ * @data : directory
+ * Return: nothing
+ */
+void directory_unload(struct directory_t *data)
+{
+        int i;
+
+        if (data->file_data != NULL) {
+                for (i=0; i<data->file_count; i++) {
+                        if (data->file_data[i] != NULL) {
+                                munmap(data->file_data[i], data->file_size[i]);
+                        }
+                }
+                free(data->file_data);
+        }
+
+        if (data->file_size != NULL) {
+                free(data->file_size);
+        }
+
+        data->file_data = NULL;
+        data->file_size = NULL;
+}
+
+
 int mkdirf(int mode, const char *fmt, ...)
 {
         va_list args;
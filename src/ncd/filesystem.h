@@ -7,13 +7,17 @@
 #include <sys/stat.h>
 
 struct directory_t {
-        char  *path;
-        char **file_path;
-        char **file_name;
-        int    file_count;
+        char           *path;
+        char          **file_path;
+        char          **file_name;
+        unsigned char **file_data;      /* Contents (see directory_load) */
+        size_t         *file_size;
+        int             file_count;
 };
 
 void directory_scan(char *path, struct directory_t *data);
+int  directory_load(struct directory_t *data);
+void directory_unload(struct directory_t *data);
 int mkdirf(int mode, const char *fmt, ...);
 FILE *fopenf(const char *mode, const char *fmt, ...);
 int file_length(FILE *file);
@@ -2,237 +2,625 @@
 #include <stdio.h>
 #include <stdbool.h>
 #include <string.h>
+#include <limits.h>
 #include <errno.h>
 #include <assert.h>
+#include <stdatomic.h>
 #include "filesystem.h"
 #include "ncd.h"
+#include "schedule.h"
+#include "store.h"
 #include "module/mod_zlib.h"
 #include "module/mod_bzlib.h"
 
 
-typedef int (*cmpr1_t)(FILE*, FILE*);
-typedef int (*cmpr2_t)(FILE*, FILE*, FILE*);
+/* Compressed size of one or two buffers, also written to a target if given */
+typedef long (*size1_t)(const void*, size_t, FILE*);
+typedef long (*size2_t)(const void*, size_t, const void*, size_t, FILE*);
 
 
-void run_compression(struct directory_t *dir, cmpr1_t __cmpr1, cmpr2_t __cmpr2, const char *ext)
+/* Options given on the command line */
+struct opts_t {
+        int jobs;               /* Worker threads */
+        int keep;               /* Write compressed files too */
+        int symmetry;           /* NCD_FULL, NCD_UPPER or NCD_AVERAGE */
+        int incremental;        /* Reuse sizes from the results store */
+        int binary;             /* Write ncd.bin instead of ncd.dat/ncd.key */
+};
+
+
+/**
+ * write_matrix()
+ * ``````````````
+ * Write the matrix of a run, in the format the options ask for.
+ */
+void write_matrix(struct ncd_t *ncd, struct directory_t *dir, struct opts_t *opts)
 {
-        int i;
-        int j;
+        if (opts->binary) {
+                if (ncd_print_binary(ncd, dir, "ncd.bin") < 0) {
+                        fprintf(stderr, "Could not write ncd.bin\n");
+                }
+        } else {
+                ncd_print_2files(ncd, dir);
+        }
+}
 
-        FILE *one;
-        FILE *two;
-        FILE *dst;
 
-        int one_z;
-        int two_z;
-        int dst_z;
+/*
+ * One all-pairs run. Jobs 0..n-1 compress the single files, 
+ * and the jobs after that compress the pairs (or, for zlib,
+ * whole rows of pairs), so every job fills its own cells of 
+ * the ncd structure and nothing else.
+ */
+struct task_t {
+        struct directory_t *dir;
+        struct ncd_t       *ncd;
+        struct opts_t      *opts;
+        size1_t             size1;
+        size2_t             size2;
+        const char         *ext;
+        int                 keep;       /* Write compressed files too */
+        int                 pairs;      /* Pairs to compress (see ncd_pair()) */
+        struct store_t     *store;      /* Sizes from earlier runs, or NULL */
+        uint64_t           *hash;       /* Content hash of each file */
+        char                store_path[4096];
+        atomic_int          failed;
+};
+
+
+void task_init(struct task_t *t, struct directory_t *dir, size1_t __size1, size2_t __size2, const char *ext, struct opts_t *opts)
+{
+        int n = dir->file_count;
+
+        t->dir   = dir;
+        t->ncd   = ncd_create(n);
+        t->opts  = opts;
+        t->size1 = __size1;
+        t->size2 = __size2;
+        t->ext   = ext;
+        t->store = NULL;
+        t->hash  = NULL;
+        atomic_init(&t->failed, 0);
+
+        /* External compressors (no size function) can only write files */
+        t->keep = opts->keep || __size1 == NULL;
+
+        t->ncd->symmetry = opts->symmetry;
+
+        /* Only the pairs the symmetry needs become jobs */
+        if (ncd_pairs(t->ncd) > INT_MAX - n) {
+                fprintf(stderr, "Too many files (%d) for one run.\n", n);
+                exit(1);
+        }
+
+        t->pairs = (int)ncd_pairs(t->ncd);
+
+        if (t->keep) {
+                mkdirf(S_IRWXU|S_IRWXG|S_IRWXO, "%s__ncd", dir->path);
+        }
+}
 
-        struct ncd_t *ncd = ncd_create(dir->file_count);
+
+void print_single(struct directory_t *dir, int i, int one_z, int dst_z, const char *ext)
+{
+        fprintf(stdout,
+                "SOURCE: %s\n" 
+                "TARGET: %s.%s\n"
+                "\tSource size: %d bits\n"
+                "\tTarget size: %d bits\n"
+                "\tCompressed: %d bits\n"
+                "\tComp. Ratio: %g bits\n\n",
+                dir->file_name[i],
+                dir->file_name[i], ext,
+                one_z,
+                dst_z,
+                one_z - dst_z,
+                (double)((double)dst_z/(double)one_z)
+        );
+}
+
+
+void print_pair(struct directory_t *dir, int i, int j, int one_z, int two_z, int dst_z, const char *ext)
+{
+        fprintf(stdout,
+                "SOURCE: %s(+)%s\n" 
+                "TARGET: %s%s.%s\n"
+                "\tSource size: %d bits\n"
+                "\tTarget size: %d bits\n"
+                "\tCompressed: %d bits\n"
+                "\tComp. Ratio: %g bits\n\n",
+                dir->file_name[i], dir->file_name[j],
+                dir->file_name[i], dir->file_name[j], ext,
+                one_z + two_z,
+                dst_z,
+                (one_z+two_z) - dst_z,
+                (double)((double)dst_z/(double)((double)one_z+(double)two_z))
+        );
+}
+
+
+/**
+ * task_fail()
+ * ```````````
+ * Note that a job could not be done.
+ *
+ * @t    : The run
+ * @msg  : What went wrong
+ * Return: nothing
+ *
+ * NOTE
+ * The other jobs still finish, but the matrix is not printed,
+ * so that a gap is never passed off as a result.
+ */
+void task_fail(struct task_t *t, const char *msg)
+{
+        fprintf(stdout, "%s\n", msg);
+        atomic_store(&t->failed, 1);
+}
+
+
+/**
+ * task_store_open()
+ * `````````````````
+ * Load the results store for the task's compressor, and hash each file.
+ *
+ * NOTE
+ * The files must be loaded (see directory_load()). The store
+ * lives in the corpus's __ncd directory, one per compressor.
+ */
+void task_store_open(struct task_t *t)
+{
+        struct directory_t *dir = t->dir;
+        int i;
 
         mkdirf(S_IRWXU|S_IRWXG|S_IRWXO, "%s__ncd", dir->path);
 
+        snprintf(t->store_path, sizeof(t->store_path), "%s__ncd/store.%s", dir->path, t->ext);
+
+        t->store = store_load(t->store_path);
+        t->hash  = calloc(dir->file_count, sizeof(uint64_t));
+
         for (i=0; i<dir->file_count; i++) {
+                t->hash[i] = store_hash(dir->file_data[i], dir->file_size[i]);
+        }
+}
 
-                one = fopen(dir->file_path[i], "r+");
-                dst = fopenf("w+", "%s__ncd/%s.%s", dir->path, dir->file_name[i], ext);
 
-                if (one != NULL && dst != NULL) {
-                        __cmpr1(one, dst);
+/**
+ * task_lookup()
+ * `````````````
+ * Find a size from an earlier run, for a single (@j < 0) or pair.
+ *
+ * Return: the size, or -1 if it has to be compressed.
+ *
+ * NOTE
+ * With --keep every file has to be written, so nothing is reused.
+ */
+long task_lookup(struct task_t *t, int i, int j)
+{
+        if (t->store == NULL || t->keep) {
+                return -1;
+        }
 
-                        one_z = (int)file_length(one);
-                        dst_z = (int)file_length(dst);
+        if (j < 0) {
+                return store_get_single(t->store, t->hash[i]);
+        } else {
+                return store_get_pair(t->store, t->hash[i], t->hash[j]);
+        }
+}
 
-                        ncd->size_single[i] = dst_z;
 
-                        fprintf(stdout,
-                                "SOURCE: %s\n" 
-                                "TARGET: %s.zpaq\n"
-                                "\tSource size: %d bits\n"
-                                "\tTarget size: %d bits\n"
-                                "\tCompressed: %d bits\n"
-                                "\tComp. Ratio: %g bits\n\n",
-                                dir->file_name[i],
-                                dir->file_name[i],
-                                one_z,
-                                dst_z,
-                                one_z - dst_z,
-                                (double)((double)dst_z/(double)one_z)
-                        );
+/**
+ * task_store_close()
+ * ``````````````````
+ * Record the sizes of a run that succeeded in its results store.
+ */
+void task_store_close(struct task_t *t)
+{
+        struct ncd_t *ncd = t->ncd;
+        int n = t->dir->file_count;
+        int i;
+        int j;
 
-                } else {
-                        fprintf(stdout, "One of the file streams is NULL\n");
-                        /* 
-                         * Don't let the size_single array get fucked 
-                         * by leaving a gap from the else { condition 
-                         */
-                        return;
+        if (t->store == NULL) {
+                return;
+        }
+
+        if (!atomic_load(&t->failed)) {
+                for (i=0; i<n; i++) {
+                        store_put_single(t->store, t->hash[i], ncd->size_single[i]);
+
+                        for (j=0; j<n; j++) {
+                                if (ncd_wanted(ncd, i, j)) {
+                                        store_put_pair(t->store, t->hash[i], t->hash[j], ncd->size_double[i][j]);
+                                }
+                        }
+                }
+
+                if (store_save(t->store, t->store_path) < 0) {
+                        fprintf(stderr, "Could not write %s\n", t->store_path);
                 }
         }
 
-        for (i=0; i<dir->file_count; i++) {
-                for (j=0; j<dir->file_count; j++) {
+        store_free(t->store);
+        free(t->hash);
 
-                        one = fopen(dir->file_path[i], "r+");
-                        two = fopen(dir->file_path[j], "r+");
+        t->store = NULL;
+        t->hash  = NULL;
+}
 
-                        dst = fopenf("w+", "%s__ncd/%s%s.%s", dir->path, dir->file_name[i], dir->file_name[j], ext);
 
-                        if (one != NULL && two != NULL && dst != NULL) {
-                                __cmpr2(one, two, dst);
+/**
+ * task_single()
+ * `````````````
+ * Compress file @i on its own, through the task's compressor.
+ */
+void task_single(struct task_t *t, int i)
+{
+        struct directory_t *dir = t->dir;
 
-                                one_z = (int)file_length(one);
-                                two_z = (int)file_length(two);
-                                dst_z = (int)file_length(dst);
+        FILE *dst = NULL;
 
-                                ncd->size_double[i][j] = dst_z;
+        int one_z;
+        int dst_z;
 
-                                fprintf(stdout,
-                                        "SOURCE: %s(+)%s\n" 
-                                        "TARGET: %s%s.zpaq\n"
-                                        "\tSource size: %d bits\n"
-                                        "\tTarget size: %d bits\n"
-                                        "\tCompressed: %d bits\n"
-                                        "\tComp. Ratio: %g bits\n\n",
-                                        dir->file_name[i], dir->file_name[j],
-                                        dir->file_name[i], dir->file_name[j],
-                                        one_z + two_z,
-                                        dst_z,
-                                        (one_z+two_z) - dst_z,
-                                        (double)((double)dst_z/(double)((double)one_z+(double)two_z))
-                                );
+        if (t->keep) {
+                dst = fopenf("w+", "%s__ncd/%s.%s", dir->path, dir->file_name[i], t->ext);
+        }
 
-                        } else {
-                                fprintf(stdout, "One of the file streams is NULL\n");
-                                /* 
-                                 * Don't let the size_single array get fucked 
-                                 * by leaving a gap from the else { condition 
-                                 */
-                                return;
-                        }
+        if (dst != NULL || !t->keep) {
+                one_z = (int)dir->file_size[i];
+                dst_z = (int)task_lookup(t, i, -1);
+
+                if (dst_z < 0) {
+                        dst_z = (int)t->size1(dir->file_data[i], dir->file_size[i], dst);
                 }
+
+                t->ncd->size_single[i] = dst_z;
+
+                print_single(dir, i, one_z, dst_z, t->ext);
+        } else {
+                task_fail(t, "One of the file streams is NULL");
         }
 
-        ncd_print_2files(ncd, dir);
+        if (dst != NULL) {
+                fclose(dst);
+        }
 }
 
 
-void shell_compression(struct directory_t *dir)
+/**
+ * task_pair()
+ * ```````````
+ * Compress file @i followed by file @j, through the task's compressor.
+ */
+void task_pair(struct task_t *t, int i, int j)
 {
-        int i;
-        int j;
+        struct directory_t *dir = t->dir;
+
+        FILE *dst = NULL;
+
+        int one_z;
+        int two_z;
+        int dst_z;
+
+        if (t->keep) {
+                dst = fopenf("w+", "%s__ncd/%s%s.%s", dir->path, dir->file_name[i], dir->file_name[j], t->ext);
+        }
+
+        if (dst != NULL || !t->keep) {
+                one_z = (int)dir->file_size[i];
+                two_z = (int)dir->file_size[j];
+                dst_z = (int)task_lookup(t, i, j);
+
+                if (dst_z < 0) {
+                        dst_z = (int)t->size2(dir->file_data[i], dir->file_size[i], 
+                                              dir->file_data[j], dir->file_size[j], dst);
+                }
+
+                t->ncd->size_double[i][j] = dst_z;
+
+                print_pair(dir, i, j, one_z, two_z, dst_z, t->ext);
+        } else {
+                task_fail(t, "One of the file streams is NULL");
+        }
+
+        if (dst != NULL) {
+                fclose(dst);
+        }
+}
+
+
+/**
+ * task_row_zlib()
+ * ```````````````
+ * Compress file @i followed by each file j, using zlib.
+ *
+ * NOTE
+ * x_i is deflated once into a snapshot, and each C(x_i x_j) 
+ * is then found by continuing a copy of the snapshot with 
+ * x_j alone, instead of deflating x_i all over again.
+ */
+void task_row_zlib(struct task_t *t, int i)
+{
+        struct directory_t *dir = t->dir;
+        struct zlib_prefix_t prefix;
 
-        FILE *one;
-        FILE *two;
         FILE *dst;
 
         int one_z;
         int two_z;
         int dst_z;
+        int missing = 0;
+        int j;
 
-        struct ncd_t *ncd = ncd_create(dir->file_count);
+        one_z = (int)dir->file_size[i];
 
-        mkdirf(S_IRWXU|S_IRWXG|S_IRWXO, "%s__ncd", dir->path);
+        /* Take what earlier runs found, and only deflate x_i if any is left */
+        for (j=0; j<dir->file_count; j++) {
+                if (ncd_wanted(t->ncd, i, j)) {
+                        if ((dst_z = (int)task_lookup(t, i, j)) < 0) {
+                                missing++;
+                                continue;
+                        }
 
-        for (i=0; i<dir->file_count; i++) {
+                        t->ncd->size_double[i][j] = dst_z;
 
-                shell("zpaq a %s__ncd/%s.zpaq %s -method 56", 
-                        dir->path, 
-                        dir->file_name[i],
-                        dir->file_path[i]
-                );
+                        print_pair(dir, i, j, one_z, (int)dir->file_size[j], dst_z, "gz");
+                }
+        }
 
-                one = fopen(dir->file_path[i], "r+");
-                dst = fopenf("r+", "%s__ncd/%s.zpaq", dir->path, dir->file_name[i]);
+        if (missing == 0) {
+                return;
+        }
 
-                if (one!=NULL && dst!=NULL) {
+        if (zlib_prefix_init(&prefix, dir->file_data[i], dir->file_size[i], t->keep) != Z_OK) {
+                task_fail(t, "Could not compress a file");
+                return;
+        }
 
-                        one_z = (int)file_length(one);
-                        dst_z = (int)file_length(dst);
+        for (j=0; j<dir->file_count; j++) {
 
-                        ncd->size_single[i] = dst_z;
+                if (!ncd_wanted(t->ncd, i, j) || task_lookup(t, i, j) >= 0) {
+                        continue;
+                }
 
-                        fprintf(stdout,
-                                "SOURCE: %s\n" 
-                                "TARGET: %s.zpaq\n"
-                                "\tSource size: %d bits\n"
-                                "\tTarget size: %d bits\n"
-                                "\tCompressed: %d bits\n"
-                                "\tComp. Ratio: %g bits\n\n",
-                                dir->file_name[i],
-                                dir->file_name[i],
-                                one_z,
-                                dst_z,
-                                one_z - dst_z,
-                                (double)((double)dst_z/(double)one_z)
-                        );
+                dst = NULL;
 
+                if (t->keep) {
+                        dst = fopenf("w+", "%s__ncd/%s%s.gz", dir->path, dir->file_name[i], dir->file_name[j]);
+                }
+
+                if (dst != NULL || !t->keep) {
+                        two_z = (int)dir->file_size[j];
+                        dst_z = (int)zlib_size_prefix(&prefix, dir->file_data[j], dir->file_size[j], dst);
+
+                        t->ncd->size_double[i][j] = dst_z;
+
+                        print_pair(dir, i, j, one_z, two_z, dst_z, "gz");
                 } else {
-                        fprintf(stdout, "One of the file streams is NULL\n");
-                        /* 
-                         * Don't let the size_single array get fucked 
-                         * by leaving a gap from the else { condition 
-                         */
-                        return;
+                        task_fail(t, "One of the file streams is NULL");
+                }
+
+                if (dst != NULL) {
+                        fclose(dst);
                 }
         }
 
-        for (i=0; i<dir->file_count; i++) {
-                for (j=0; j<dir->file_count; j++) {
+        zlib_prefix_free(&prefix);
+}
 
-                        shell("zpaq a %s__ncd/%s%s.zpaq %s %s -method 56", 
-                                dir->path, 
-                                dir->file_name[i], dir->file_name[j],
-                                dir->file_path[i], dir->file_path[j]
-                        );
 
-                        one = fopen(dir->file_path[i], "r+");
-                        two = fopen(dir->file_path[j], "r+");
+/**
+ * task_finish()
+ * `````````````
+ * Write out the matrix of a run, if every job succeeded.
+ */
+void task_finish(struct task_t *t)
+{
+        if (atomic_load(&t->failed)) {
+                fprintf(stdout, "Some compressions failed; no matrix written.\n");
+                return;
+        }
 
-                        dst = fopenf("r+", "%s__ncd/%s%s.zpaq", 
-                                dir->path, 
-                                dir->file_name[i], 
-                                dir->file_name[j]
-                        );
+        write_matrix(t->ncd, t->dir, t->opts);
+}
 
-                        if (one!=NULL && two!=NULL && dst!=NULL) {
 
-                                one_z = (int)file_length(one);
-                                two_z = (int)file_length(two);
-                                dst_z = (int)file_length(dst);
 
-                                ncd->size_double[i][j] = dst_z;
+/******************************************************************************
+ * IN-PROCESS COMPRESSORS (zlib, bzlib)
+ *
+ * The corpus is read into memory once, before any job runs, and every
+ * compression works from those buffers; no job opens an input file.
+ ******************************************************************************/
 
-                                fprintf(stdout,
-                                        "SOURCE: %s(+)%s\n" 
-                                        "TARGET: %s%s.zpaq\n"
-                                        "\tSource size: %d bits\n"
-                                        "\tTarget size: %d bits\n"
-                                        "\tCompressed: %d bits\n"
-                                        "\tComp. Ratio: %g bits\n\n",
-                                        dir->file_name[i], dir->file_name[j],
-                                        dir->file_name[i], dir->file_name[j],
-                                        (one_z+two_z),
-                                        dst_z,
-                                        (one_z+two_z) - dst_z,
-                                        (double)((double)dst_z/(double)((double)one_z+(double)two_z))
-                                );
+void run_job(int job, void *arg)
+{
+        struct task_t *t = arg;
+        int n = t->dir->file_count;
+        int i;
+        int j;
 
-                        } else {
-                                fprintf(stdout, "One of the file streams is NULL\n");
-                                /* 
-                                 * Don't let the size_single array get fucked 
-                                 * by leaving a gap from the else { condition 
-                                 */
-                                return;
-                        }
+        if (job < n) {
+                task_single(t, job);
+        } else {
+                ncd_pair(t->ncd, job-n, &i, &j);
+                task_pair(t, i, j);
+        }
+}
+
+
+void run_compression(struct directory_t *dir, size1_t __size1, size2_t __size2, const char *ext, struct opts_t *opts)
+{
+        struct task_t t;
+        int n = dir->file_count;
+
+        if (directory_load(dir) < 0) {
+                return;
+        }
+
+        task_init(&t, dir, __size1, __size2, ext, opts);
+
+        if (opts->incremental) {
+                task_store_open(&t);
+        }
+
+        schedule_run(n + t.pairs, opts->jobs, run_job, &t);
+
+        task_store_close(&t);
+        task_finish(&t);
+
+        directory_unload(dir);
+}
+
+
+void zlib_job(int job, void *arg)
+{
+        struct task_t *t = arg;
+        int n = t->dir->file_count;
+
+        if (job < n) {
+                task_single(t, job);
+        } else {
+                task_row_zlib(t, job-n);
+        }
+}
+
+
+void zlib_compression(struct directory_t *dir, struct opts_t *opts)
+{
+        struct task_t t;
+        int n = dir->file_count;
+
+        if (directory_load(dir) < 0) {
+                return;
+        }
+
+        task_init(&t, dir, zlib_size, NULL, "gz", opts);
+
+        if (opts->incremental) {
+                task_store_open(&t);
+        }
+
+        schedule_run(n + n, opts->jobs, zlib_job, &t);
+
+        task_store_close(&t);
+        task_finish(&t);
+
+        directory_unload(dir);
+}
+
+
+
+/******************************************************************************
+ * EXTERNAL COMPRESSORS (zpaq, gypsy)
+ *
+ * Each job runs one child process through shell() and waits for it, 
+ * so with N workers there are at most N compressors running at once.
+ ******************************************************************************/
+
+/**
+ * task_measure()
+ * ``````````````
+ * Record the size of a compressor's output, for a single (@j < 0) or pair.
+ */
+void task_measure(struct task_t *t, int i, int j)
+{
+        struct directory_t *dir = t->dir;
+
+        FILE *one;
+        FILE *two = NULL;
+        FILE *dst;
+
+        int one_z;
+        int two_z;
+        int dst_z;
+
+        one = fopen(dir->file_path[i], "r+");
+
+        if (j < 0) {
+                dst = fopenf("r+", "%s__ncd/%s.%s", dir->path, dir->file_name[i], t->ext);
+        } else {
+                two = fopen(dir->file_path[j], "r+");
+                dst = fopenf("r+", "%s__ncd/%s%s.%s", dir->path, dir->file_name[i], dir->file_name[j], t->ext);
+        }
+
+        if (one != NULL && dst != NULL && (j < 0 || two != NULL)) {
+
+                one_z = (int)file_length(one);
+                dst_z = (int)file_length(dst);
+
+                if (j < 0) {
+                        t->ncd->size_single[i] = dst_z;
+                        print_single(dir, i, one_z, dst_z, t->ext);
+                } else {
+                        two_z = (int)file_length(two);
+                        t->ncd->size_double[i][j] = dst_z;
+                        print_pair(dir, i, j, one_z, two_z, dst_z, t->ext);
                 }
+        } else {
+                task_fail(t, "One of the file streams is NULL");
+        }
+
+        if (one != NULL) {
+                fclose(one);
+        }
+        if (two != NULL) {
+                fclose(two);
+        }
+        if (dst != NULL) {
+                fclose(dst);
+        }
+}
+
+
+void shell_job(int job, void *arg)
+{
+        struct task_t *t = arg;
+        struct directory_t *dir = t->dir;
+        int n = dir->file_count;
+        int i;
+        int j;
+
+        if (job < n) {
+                i = job;
+
+                shell("zpaq a %s__ncd/%s.zpaq %s -method 56", 
+                        dir->path, 
+                        dir->file_name[i],
+                        dir->file_path[i]
+                );
+
+                task_measure(t, i, -1);
+        } else {
+                ncd_pair(t->ncd, job-n, &i, &j);
+
+                shell("zpaq a %s__ncd/%s%s.zpaq %s %s -method 56", 
+                        dir->path, 
+                        dir->file_name[i], dir->file_name[j],
+                        dir->file_path[i], dir->file_path[j]
+                );
+
+                task_measure(t, i, j);
         }
+}
 
-        ncd_print_2files(ncd, dir);
+
+void shell_compression(struct directory_t *dir, struct opts_t *opts)
+{
+        struct task_t t;
+        int n = dir->file_count;
+
+        task_init(&t, dir, NULL, NULL, "zpaq", opts);
+
+        schedule_run(n + t.pairs, opts->jobs, shell_job, &t);
+
+        task_finish(&t);
 }
 
 
-void shell_calculate_ncd(struct directory_t *dir)
+void shell_calculate_ncd(struct directory_t *dir, struct opts_t *opts)
 {
         int i;
         int j;
@@ -242,6 +630,8 @@ void shell_calculate_ncd(struct directory_t *dir)
 
         struct ncd_t *ncd = ncd_create(dir->file_count);
 
+        ncd->symmetry = opts->symmetry;
+
         for (i=0; i<dir->file_count; i++) {
 
                 dst = fopenf("r+", "%s__ncd/%s.zpaq", dir->path, dir->file_name[i]);
@@ -265,6 +655,10 @@ void shell_calculate_ncd(struct directory_t *dir)
         for (i=0; i<dir->file_count; i++) {
                 for (j=0; j<dir->file_count; j++) {
 
+                        if (!ncd_wanted(ncd, i, j)) {
+                                continue;
+                        }
+
                         dst = fopenf("r+", "%s__ncd/%s%s.zpaq", dir->path, dir->file_name[i], dir->file_name[j]);
 
                         if (dst != NULL) {
@@ -284,28 +678,20 @@ void shell_calculate_ncd(struct directory_t *dir)
                 }
         }
 
-        ncd_print_2files(ncd, dir);
+        write_matrix(ncd, dir, opts);
 }
 
 
-void gypsy_compression(struct directory_t *dir)
+void gypsy_job(int job, void *arg)
 {
+        struct task_t *t = arg;
+        struct directory_t *dir = t->dir;
+        int n = dir->file_count;
         int i;
         int j;
 
-        FILE *one;
-        FILE *two;
-        FILE *dst;
-
-        int one_z;
-        int two_z;
-        int dst_z;
-
-        struct ncd_t *ncd = ncd_create(dir->file_count);
-
-        mkdirf(S_IRWXU|S_IRWXG|S_IRWXO, "%s__ncd", dir->path);
-
-        for (i=0; i<dir->file_count; i++) {
+        if (job < n) {
+                i = job;
 
                 shell("gypsy -c %s -o %s__ncd/%s.gy", 
                         dir->file_path[i],
@@ -313,98 +699,35 @@ void gypsy_compression(struct directory_t *dir)
                         dir->file_name[i]
                 );
 
-                one = fopen(dir->file_path[i], "r+");
-                dst = fopenf("r+", "%s__ncd/%s.gy", dir->path, dir->file_name[i]);
-
-                if (one!=NULL && dst!=NULL) {
-
-                        one_z = (int)file_length(one);
-                        dst_z = (int)file_length(dst);
-
-                        ncd->size_single[i] = dst_z;
+                task_measure(t, i, -1);
+        } else {
+                ncd_pair(t->ncd, job-n, &i, &j);
 
-                        fprintf(stdout,
-                                "SOURCE: %s\n" 
-                                "TARGET: %s.gy\n"
-                                "\tSource size: %d bits\n"
-                                "\tTarget size: %d bits\n"
-                                "\tCompressed: %d bits\n"
-                                "\tComp. Ratio: %g bits\n\n",
-                                dir->file_name[i],
-                                dir->file_name[i],
-                                one_z,
-                                dst_z,
-                                one_z - dst_z,
-                                (double)((double)dst_z/(double)one_z)
-                        );
+                shell("cat %s %s | gypsy -c -o %s__ncd/%s%s.gy", 
+                        dir->file_path[i], dir->file_path[j],
+                        dir->path, 
+                        dir->file_name[i], dir->file_name[j]
+                );
 
-                } else {
-                        fprintf(stdout, "One of the file streams is NULL\n");
-                        /* 
-                         * Don't let the size_single array get fucked 
-                         * by leaving a gap from the else { condition 
-                         */
-                        return;
-                }
+                task_measure(t, i, j);
         }
+}
 
-        for (i=0; i<dir->file_count; i++) {
-                for (j=0; j<dir->file_count; j++) {
-
-                        shell("cat %s %s | gypsy -c -o %s__ncd/%s%s.gy", 
-                                dir->file_path[i], dir->file_path[j],
-                                dir->path, 
-                                dir->file_name[i], dir->file_name[j]
-                        );
-
-                        one = fopen(dir->file_path[i], "r+");
-                        two = fopen(dir->file_path[j], "r+");
-
-                        dst = fopenf("r+", "%s__ncd/%s%s.gy", 
-                                dir->path, 
-                                dir->file_name[i], 
-                                dir->file_name[j]
-                        );
-
-                        if (one!=NULL && two!=NULL && dst!=NULL) {
 
-                                one_z = (int)file_length(one);
-                                two_z = (int)file_length(two);
-                                dst_z = (int)file_length(dst);
-
-                                ncd->size_double[i][j] = dst_z;
+void gypsy_compression(struct directory_t *dir, struct opts_t *opts)
+{
+        struct task_t t;
+        int n = dir->file_count;
 
-                                fprintf(stdout,
-                                        "SOURCE: %s(+)%s\n" 
-                                        "TARGET: %s%s.gy\n"
-                                        "\tSource size: %d bits\n"
-                                        "\tTarget size: %d bits\n"
-                                        "\tCompressed: %d bits\n"
-                                        "\tComp. Ratio: %g bits\n\n",
-                                        dir->file_name[i], dir->file_name[j],
-                                        dir->file_name[i], dir->file_name[j],
-                                        (one_z+two_z),
-                                        dst_z,
-                                        (one_z+two_z) - dst_z,
-                                        (double)((double)dst_z/(double)((double)one_z+(double)two_z))
-                                );
+        task_init(&t, dir, NULL, NULL, "gy", opts);
 
-                        } else {
-                                fprintf(stdout, "One of the file streams is NULL\n");
-                                /* 
-                                 * Don't let the size_single array get fucked 
-                                 * by leaving a gap from the else { condition 
-                                 */
-                                return;
-                        }
-                }
-        }
+        schedule_run(n + t.pairs, opts->jobs, gypsy_job, &t);
 
-        ncd_print_2files(ncd, dir);
+        task_finish(&t);
 }
 
 
-void gypsy_calculate_ncd(struct directory_t *dir)
+void gypsy_calculate_ncd(struct directory_t *dir, struct opts_t *opts)
 {
         int i;
         int j;
@@ -414,6 +737,8 @@ void gypsy_calculate_ncd(struct directory_t *dir)
 
         struct ncd_t *ncd = ncd_create(dir->file_count);
 
+        ncd->symmetry = opts->symmetry;
+
         for (i=0; i<dir->file_count; i++) {
 
                 dst = fopenf("r+", "%s__ncd/%s.gy", dir->path, dir->file_name[i]);
@@ -437,6 +762,10 @@ void gypsy_calculate_ncd(struct directory_t *dir)
         for (i=0; i<dir->file_count; i++) {
                 for (j=0; j<dir->file_count; j++) {
 
+                        if (!ncd_wanted(ncd, i, j)) {
+                                continue;
+                        }
+
                         dst = fopenf("r+", "%s__ncd/%s%s.gy", dir->path, dir->file_name[i], dir->file_name[j]);
 
                         if (dst != NULL) {
@@ -456,43 +785,68 @@ void gypsy_calculate_ncd(struct directory_t *dir)
                 }
         }
 
-        ncd_print_2files(ncd, dir);
+        write_matrix(ncd, dir, opts);
 }
 
 int main(int argc, char **argv)
 {
         struct directory_t dir;
+        struct opts_t opts = { 1, 0, NCD_FULL, 0, 0 };
+        char *mode = NULL;
+        char *path = NULL;
+        int i;
 
-        if (argc == 3) {
-                directory_scan(argv[2], &dir);
+        for (i=1; i<argc; i++) {
+                if (!strcmp(argv[i], "--jobs") && i+1 < argc) {
+                        opts.jobs = atoi(argv[++i]);
+                } else if (!strcmp(argv[i], "--keep")) {
+                        opts.keep = 1;
+                } else if (!strcmp(argv[i], "--binary")) {
+                        opts.binary = 1;
+                } else if (!strcmp(argv[i], "--incremental")) {
+                        opts.incremental = 1;
+                } else if (!strcmp(argv[i], "--symmetric")) {
+                        opts.symmetry = NCD_UPPER;
+                } else if (!strcmp(argv[i], "--symmetric=average")) {
+                        opts.symmetry = NCD_AVERAGE;
+                } else if (mode == NULL) {
+                        mode = argv[i];
+                } else if (path == NULL) {
+                        path = argv[i];
+                } else {
+                        path = NULL;
+                        break;
+                }
+        }
+
+        if (mode != NULL && path != NULL) {
+                directory_scan(path, &dir);
 
-                if (!strcmp(argv[1], "--zlib")) {
+                if (!strcmp(mode, "--zlib")) {
                         /* Compress and calculate NCD using zlib */
-                        run_compression(&dir, zlib_compress, zlib_compress_cat, "gz");
-                } else if (!strcmp(argv[1], "--bzlib")) {
+                        zlib_compression(&dir, &opts);
+                } else if (!strcmp(mode, "--bzlib")) {
                         /* Compress and calculate NCD using bzlib2 */
-                        run_compression(&dir, bzlib_compress, bzlib_compress_cat, "bz2");
-                } else if (!strcmp(argv[1], "--zpaq")) {
+                        run_compression(&dir, bzlib_size, bzlib_size_cat, "bz2", &opts);
+                } else if (!strcmp(mode, "--zpaq")) {
                         /* Compress and calculate NCD using zpaq */
-                        shell_compression(&dir);
-                } else if (!strcmp(argv[1], "--zpaqncd")) {
+                        shell_compression(&dir, &opts);
+                } else if (!strcmp(mode, "--zpaqncd")) {
                         /* Calculate NCD using zpaq files */
-                        shell_calculate_ncd(&dir);
-                } else if (!strcmp(argv[1], "--gypsy")) {
+                        shell_calculate_ncd(&dir, &opts);
+                } else if (!strcmp(mode, "--gypsy")) {
                         /* Compress and calculate NCD using zpaq */
-                        gypsy_compression(&dir);
-                } else if (!strcmp(argv[1], "--gypsyncd")) {
+                        gypsy_compression(&dir, &opts);
+                } else if (!strcmp(mode, "--gypsyncd")) {
                         /* Calculate NCD using zpaq files */
-                        gypsy_calculate_ncd(&dir);
+                        gypsy_calculate_ncd(&dir, &opts);
                 } else {
-                        printf("%s? I don't know that one.\n", argv[1]);
+                        printf("%s? I don't know that one.\n", mode);
                 }
         } else {
-                printf("Usage: %s --zlib|--bzlib|--zpaq|--zpaqncd|--gypsy|--gypsyncd <DIRECTORY>\n", argv[0]);
+                printf("Usage: %s [--jobs N] [--keep] [--incremental] [--symmetric[=average]] [--binary] --zlib|--bzlib|--zpaq|--zpaqncd|--gypsy|--gypsyncd <DIRECTORY>\n", argv[0]);
         }
 
         return 0;
 
 }
-
-
@@ -1,8 +1,11 @@
 #include <stdio.h>
+#include <stdint.h>
 #include <string.h>
 #include <bzlib.h>
+#include "mod_bzlib.h"
 
 #define BZLIB_BLOCK 16384
+#define BZLIB_MEM_BLOCK (1U << 30)
 
 
 /**
@@ -146,6 +149,128 @@ int bzlib_compress_cat(FILE *one, FILE *two, FILE *dst)
 }
 
 
+/**
+ * bzlib_compress_mem()
+ * ````````````````````
+ * Run all of a source buffer through an open bzip2 stream.
+ *
+ * @stream: bzip2 stream (initialized)
+ * @src   : Source buffer (decompressed)
+ * @len   : Length of @src in bytes
+ * @last  : Finish the stream at the end of @src, if non-zero
+ * @dst   : Target file for the output, or NULL to only count it
+ * Return : 1 (success) or -1 (error)
+ *
+ * NOTE
+ * The output goes through one small scratch buffer, so 
+ * nothing is kept in memory when @dst is NULL. The total
+ * output is kept by bzlib in the stream's total_out fields.
+ */
+static int bzlib_compress_mem(bz_stream *stream, const char *src, size_t len, int last, FILE *dst)
+{
+        char    out[BZLIB_BLOCK];
+        size_t  have;
+        int     action;
+        int     err;
+
+        /* BZ_RUN with no input is a BZ_PARAM_ERROR, so there's nothing to do */
+        if (len == 0 && !last) {
+                return 1;
+        }
+
+        /* avail_in is only an unsigned int, so take the buffer a piece at a time */
+        do {
+                stream->next_in  = (char *)src;
+                stream->avail_in = (len > BZLIB_MEM_BLOCK) ? BZLIB_MEM_BLOCK : (unsigned int)len;
+
+                src += stream->avail_in;
+                len -= stream->avail_in;
+
+                action = (last && len == 0) ? BZ_FINISH : BZ_RUN;
+
+                /*
+                 * BZ_RUN returns once the input is taken; BZ_FINISH
+                 * has to be called until the stream is ended.
+                 */
+                do {
+                        stream->next_out  = out;
+                        stream->avail_out = BZLIB_BLOCK;
+
+                        err = BZ2_bzCompress(stream, action);
+
+                        if (err != BZ_RUN_OK && err != BZ_FINISH_OK && err != BZ_STREAM_END) {
+                                fprintf(stderr, "bzlib_compress_mem: got error %d.\n", err);
+                                return -1;
+                        }
+
+                        have = BZLIB_BLOCK - stream->avail_out;
+
+                        if (dst != NULL && (fwrite(out, 1, have, dst) != have || ferror(dst))) {
+                                return -1;
+                        }
+
+                } while (stream->avail_in > 0 || (action == BZ_FINISH && err != BZ_STREAM_END));
+
+        } while (len > 0);
+
+        return 1;
+}
+
+
+/**
+ * bzlib_size()
+ * ````````````
+ * Find the compressed size of a source buffer using bzlib 
+ *
+ * @src  : Source buffer (decompressed)
+ * @len  : Length of @src in bytes
+ * @dst  : Target file (compressed), or NULL if not wanted
+ * Return: Compressed size in bytes, or -1 on error.
+ */
+long bzlib_size(const void *src, size_t len, FILE *dst)
+{
+        return bzlib_size_cat(src, len, NULL, 0, dst);
+}
+
+
+/**
+ * bzlib_size_cat()
+ * ````````````````
+ * Find the compressed size of two source buffers using bzlib 
+ *
+ * @one    : Source buffer one (decompressed)
+ * @one_len: Length of @one in bytes
+ * @two    : Source buffer two (decompressed), or NULL for none
+ * @two_len: Length of @two in bytes
+ * @dst    : Target file (compressed), or NULL if not wanted
+ * Return  : Compressed size in bytes, or -1 on error.
+ */
+long bzlib_size_cat(const void *one, size_t one_len, const void *two, size_t two_len, FILE *dst)
+{
+        bz_stream stream;
+        long      size;
+
+        memset(&stream, 0, sizeof(bz_stream));
+
+        /* Same block size, verbosity and work factor as bzlib_compress() */
+        if (BZ2_bzCompressInit(&stream, 9, 0, 30) != BZ_OK) {
+                return -1;
+        }
+
+        if (bzlib_compress_mem(&stream, one, one_len, (two == NULL), dst) < 0
+        || (two != NULL && bzlib_compress_mem(&stream, two, two_len, 1, dst) < 0)) {
+                BZ2_bzCompressEnd(&stream);
+                return -1;
+        }
+
+        size = (long)(((uint64_t)stream.total_out_hi32 << 32) | stream.total_out_lo32);
+
+        BZ2_bzCompressEnd(&stream);
+
+        return size;
+}
+
+
 /**
  * bzlib_decompress()
  * ``````````````````
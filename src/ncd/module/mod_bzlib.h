@@ -13,6 +13,8 @@
 
 int  bzlib_compress    (FILE *src, FILE *dst);
 int  bzlib_compress_cat(FILE *one, FILE *two, FILE *dst);
+long bzlib_size        (const void *src, size_t len, FILE *dst);
+long bzlib_size_cat    (const void *one, size_t one_len, const void *two, size_t two_len, FILE *dst);
 int  bzlib_decompress  (FILE *src, FILE *dst);
 
 #endif
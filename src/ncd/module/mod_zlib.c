@@ -1,57 +1,52 @@
+#include <stdlib.h>
 #include <stdio.h>
 #include <string.h>
 #include <assert.h>
 #include <zlib.h>
+#include "mod_zlib.h"
 
 #define SET_BINARY_MODE(file)
 #define ZLIB_BLOCK 16384
+#define ZLIB_MEM_BLOCK (1U << 30)
 
 #define ZLIB_COMPRESSION_LEVEL Z_BEST_COMPRESSION
 
 /**
- * zlib_compress()
- * ```````````````
- * Compress a source file to a target file using zlib
+ * zlib_deflate_file()
+ * ```````````````````
+ * Run all of a source file through an open deflate stream.
  *
- * @src  : Source file (decompressed)
- * @dst  : Target file (compressed)
+ * @stream: Deflate stream (initialized)
+ * @src   : Source file (decompressed)
+ * @last  : Finish the stream at the end of @src, if non-zero
+ * @dst   : Target file for the output, or NULL to only count it
+ * @size  : Incremented by the number of bytes of output
  * Return: 
  *      Z_OK            success 
- *      Z_MEM_ERROR     memory could not be allocated
- *      Z_STREAM_ERROR  invalid compression level
- *      Z_VERSION_ERROR linked library and zlib.h don't match
  *      Z_ERRNO         error reading or writing the files
+ *
+ * NOTE
+ * The output goes through one small scratch buffer, so 
+ * nothing is kept in memory when @dst is NULL.
  */
-int zlib_compress(FILE *src, FILE *dst)
+static int zlib_deflate_file(z_stream *stream, FILE *src, int last, FILE *dst, size_t *size)
 {
         int status;
         int flush;
         unsigned have;
-        z_stream stream;
         unsigned char in[ZLIB_BLOCK];
         unsigned char out[ZLIB_BLOCK];
 
-        /* Allocate the compressor stream state */
-        stream.zalloc  = Z_NULL;
-        stream.zfree   = Z_NULL;
-        stream.opaque  = Z_NULL;
-        status         = deflateInit(&stream, ZLIB_COMPRESSION_LEVEL);
-
-        if (status != Z_OK) {
-                return status;
-        }
-
-        /* Compress until EOF is reached (flush == Z_FINISH) */
+        /* Compress until EOF is reached */
         do {
-                stream.avail_in = fread(in, 1, ZLIB_BLOCK, src);
+                stream->avail_in = fread(in, 1, ZLIB_BLOCK, src);
 
                 if (ferror(src)) {
-                        deflateEnd(&stream);
                         return Z_ERRNO;
                 }
 
-                flush = feof(src) ? Z_FINISH : Z_NO_FLUSH;
-                stream.next_in = in;
+                flush = (last && feof(src)) ? Z_FINISH : Z_NO_FLUSH;
+                stream->next_in = in;
 
                 /* 
                  * Run deflate() on input until the output
@@ -59,38 +54,217 @@ int zlib_compress(FILE *src, FILE *dst)
                  * all of the source has been read.
                  */
                 do {
-                        stream.avail_out = ZLIB_BLOCK;
-                        stream.next_out  = out;
+                        stream->avail_out = ZLIB_BLOCK;
+                        stream->next_out  = out;
 
-                        status = deflate(&stream, flush);
+                        status = deflate(stream, flush);
 
                         /* State not clobbered */
                         assert(status != Z_STREAM_ERROR);  
 
-                        have = ZLIB_BLOCK - stream.avail_out;
+                        have = ZLIB_BLOCK - stream->avail_out;
 
-                        if (fwrite(out, 1, have, dst) != have || ferror(dst)) {
-                                deflateEnd(&stream);
+                        if (dst != NULL && (fwrite(out, 1, have, dst) != have || ferror(dst))) {
                                 return Z_ERRNO;
                         }
 
-                } while (stream.avail_out == 0);
+                        *size += have;
+
+                } while (stream->avail_out == 0);
 
                 /* All input should be used */
-                assert(stream.avail_in == 0);     
+                assert(stream->avail_in == 0);     
 
-        } while (flush != Z_FINISH);
+        } while (!feof(src));
 
-        assert(status == Z_STREAM_END);
+        if (last) {
+                assert(status == Z_STREAM_END);
+        }
 
-        /* Clean up */
+        return Z_OK;
+}
 
-        deflateEnd(&stream);
+
+/**
+ * zlib_deflate_mem()
+ * ``````````````````
+ * Run all of a source buffer through an open deflate stream.
+ *
+ * @stream: Deflate stream (initialized)
+ * @src   : Source buffer (decompressed)
+ * @len   : Length of @src in bytes
+ * @last  : Finish the stream at the end of @src, if non-zero
+ * @dst   : Target file for the output, or NULL to only count it
+ * @size  : Incremented by the number of bytes of output
+ * Return: 
+ *      Z_OK            success 
+ *      Z_ERRNO         error writing the file
+ *
+ * NOTE
+ * Deflate gives the same output however its input is split
+ * up, so this matches zlib_deflate_file() on the same bytes.
+ */
+static int zlib_deflate_mem(z_stream *stream, const unsigned char *src, size_t len, int last, FILE *dst, size_t *size)
+{
+        int status;
+        int flush;
+        unsigned have;
+        unsigned char out[ZLIB_BLOCK];
+
+        /* avail_in is only a uInt, so take the buffer a piece at a time */
+        do {
+                stream->avail_in = (len > ZLIB_MEM_BLOCK) ? ZLIB_MEM_BLOCK : (uInt)len;
+                stream->next_in  = (unsigned char *)src;
+
+                src += stream->avail_in;
+                len -= stream->avail_in;
+
+                flush = (last && len == 0) ? Z_FINISH : Z_NO_FLUSH;
+
+                do {
+                        stream->avail_out = ZLIB_BLOCK;
+                        stream->next_out  = out;
+
+                        status = deflate(stream, flush);
+
+                        /* State not clobbered */
+                        assert(status != Z_STREAM_ERROR);  
+
+                        have = ZLIB_BLOCK - stream->avail_out;
+
+                        if (dst != NULL && (fwrite(out, 1, have, dst) != have || ferror(dst))) {
+                                return Z_ERRNO;
+                        }
+
+                        *size += have;
+
+                } while (stream->avail_out == 0);
+
+                /* All input should be used */
+                assert(stream->avail_in == 0);     
+
+        } while (len > 0);
+
+        if (last) {
+                assert(status == Z_STREAM_END);
+        }
 
         return Z_OK;
 }
 
 
+/**
+ * zlib_size()
+ * ```````````
+ * Find the compressed size of a source buffer using zlib
+ *
+ * @src  : Source buffer (decompressed)
+ * @len  : Length of @src in bytes
+ * @dst  : Target file (compressed), or NULL if not wanted
+ * Return: Compressed size in bytes, or -1 on error.
+ */
+long zlib_size(const void *src, size_t len, FILE *dst)
+{
+        z_stream stream;
+        size_t size = 0;
+
+        /* Allocate the compressor stream state */
+        stream.zalloc  = Z_NULL;
+        stream.zfree   = Z_NULL;
+        stream.opaque  = Z_NULL;
+
+        if (deflateInit(&stream, ZLIB_COMPRESSION_LEVEL) != Z_OK) {
+                return -1;
+        }
+
+        if (zlib_deflate_mem(&stream, src, len, 1, dst, &size) != Z_OK) {
+                deflateEnd(&stream);
+                return -1;
+        }
+
+        deflateEnd(&stream);
+
+        return (long)size;
+}
+
+
+/**
+ * zlib_size_cat()
+ * ```````````````
+ * Find the compressed size of two source buffers using zlib
+ *
+ * @one    : Source buffer one (decompressed)
+ * @one_len: Length of @one in bytes
+ * @two    : Source buffer two (decompressed)
+ * @two_len: Length of @two in bytes
+ * @dst    : Target file (compressed), or NULL if not wanted
+ * Return  : Compressed size in bytes, or -1 on error.
+ */
+long zlib_size_cat(const void *one, size_t one_len, const void *two, size_t two_len, FILE *dst)
+{
+        z_stream stream;
+        size_t size = 0;
+
+        /* Allocate the compressor stream state */
+        stream.zalloc  = Z_NULL;
+        stream.zfree   = Z_NULL;
+        stream.opaque  = Z_NULL;
+
+        if (deflateInit(&stream, ZLIB_COMPRESSION_LEVEL) != Z_OK) {
+                return -1;
+        }
+
+        /* Don't flush until 'two' */ 
+        if (zlib_deflate_mem(&stream, one, one_len, 0, dst, &size) != Z_OK
+        ||  zlib_deflate_mem(&stream, two, two_len, 1, dst, &size) != Z_OK) {
+                deflateEnd(&stream);
+                return -1;
+        }
+
+        deflateEnd(&stream);
+
+        return (long)size;
+}
+
+
+/**
+ * zlib_compress()
+ * ```````````````
+ * Compress a source file to a target file using zlib
+ *
+ * @src  : Source file (decompressed)
+ * @dst  : Target file (compressed)
+ * Return: 
+ *      Z_OK            success 
+ *      Z_MEM_ERROR     memory could not be allocated
+ *      Z_STREAM_ERROR  invalid compression level
+ *      Z_VERSION_ERROR linked library and zlib.h don't match
+ *      Z_ERRNO         error reading or writing the files
+ */
+int zlib_compress(FILE *src, FILE *dst)
+{
+        z_stream stream;
+        size_t size = 0;
+        int status;
+
+        /* Allocate the compressor stream state */
+        stream.zalloc  = Z_NULL;
+        stream.zfree   = Z_NULL;
+        stream.opaque  = Z_NULL;
+        status         = deflateInit(&stream, ZLIB_COMPRESSION_LEVEL);
+
+        if (status != Z_OK) {
+                return status;
+        }
+
+        status = zlib_deflate_file(&stream, src, 1, dst, &size);
+
+        deflateEnd(&stream);
+
+        return status;
+}
+
+
 /**
  * zlib_compress_cat()
  * ```````````````````
@@ -108,12 +282,9 @@ int zlib_compress(FILE *src, FILE *dst)
  */
 int zlib_compress_cat(FILE *one, FILE *two, FILE *dst)
 {
-        int status;
-        int flush;
-        unsigned have;
         z_stream stream;
-        unsigned char in[ZLIB_BLOCK];
-        unsigned char out[ZLIB_BLOCK];
+        size_t size = 0;
+        int status;
 
         /* Allocate the compressor stream state */
         stream.zalloc  = Z_NULL;
@@ -125,97 +296,147 @@ int zlib_compress_cat(FILE *one, FILE *two, FILE *dst)
                 return status;
         }
 
-        /* Compress file 'one' until EOF is reached (flush == Z_FINISH) */
-        do {
-                stream.avail_in = fread(in, 1, ZLIB_BLOCK, one);
-
-                if (ferror(one)) {
-                        deflateEnd(&stream);
-                        return Z_ERRNO;
-                }
+        /* Don't flush until 'two' */ 
+        status = zlib_deflate_file(&stream, one, 0, dst, &size);
 
-                flush = feof(one) ? Z_FINISH : Z_NO_FLUSH;
+        if (status == Z_OK) {
+                status = zlib_deflate_file(&stream, two, 1, dst, &size);
+        }
 
-                stream.next_in = in;
+        deflateEnd(&stream);
 
-                /* 
-                 * Run deflate() on input until the output
-                 * buffer is no longer full. Terminate if
-                 * all of the source has been read.
-                 */
-                do {
-                        stream.avail_out = ZLIB_BLOCK;
-                        stream.next_out  = out;
+        return status;
+}
 
-                        /* Lie about flush, don't flush until 'two' */ 
-                        /*status = deflate(&stream, flush);*/
-                        status = deflate(&stream, Z_NO_FLUSH);
 
-                        /* State not clobbered */
-                        assert(status != Z_STREAM_ERROR);  
+/**
+ * zlib_prefix_init()
+ * ``````````````````
+ * Compress a source buffer into a stream that is left open, as a snapshot
+ * from which the buffer may be continued by any number of other buffers.
+ *
+ * @prefix : Prefix state to fill
+ * @one    : Source buffer (decompressed)
+ * @one_len: Length of @one in bytes
+ * @keep   : Keep the output emitted so far, if non-zero
+ * Return: 
+ *      Z_OK            success 
+ *      Z_MEM_ERROR     memory could not be allocated
+ *      Z_STREAM_ERROR  invalid compression level
+ *      Z_VERSION_ERROR linked library and zlib.h don't match
+ *
+ * NOTE
+ * The output deflate emits while @one goes in is the start
+ * of every stream continued from the snapshot. Its length is
+ * always kept in @prefix->out_len; the bytes themselves are 
+ * only kept (in @prefix->out) if they are to be written out.
+ */
+int zlib_prefix_init(struct zlib_prefix_t *prefix, const void *one, size_t one_len, int keep)
+{
+        FILE *sink = NULL;
+        int status;
 
-                        have = ZLIB_BLOCK - stream.avail_out;
+        memset(prefix, 0, sizeof(struct zlib_prefix_t));
 
-                        if (fwrite(out, 1, have, dst) != have || ferror(dst)) {
-                                deflateEnd(&stream);
-                                return Z_ERRNO;
-                        }
+        /* Allocate the compressor stream state */
+        prefix->stream.zalloc = Z_NULL;
+        prefix->stream.zfree  = Z_NULL;
+        prefix->stream.opaque = Z_NULL;
+        status                = deflateInit(&prefix->stream, ZLIB_COMPRESSION_LEVEL);
 
-                } while (stream.avail_out == 0);
+        if (status != Z_OK) {
+                return status;
+        }
 
-                /* All input should be used */
-                assert(stream.avail_in == 0);     
+        if (keep && (sink = open_memstream((char **)&prefix->out, &prefix->out_max)) == NULL) {
+                deflateEnd(&prefix->stream);
+                return Z_MEM_ERROR;
+        }
 
-        } while (flush != Z_FINISH);
+        /* Compress buffer 'one' to the end, but never flush */
+        status = zlib_deflate_mem(&prefix->stream, one, one_len, 0, sink, &prefix->out_len);
 
+        if (sink != NULL) {
+                fclose(sink);
+        }
 
-        /* Compress file 'two' until EOF is reached (flush == Z_FINISH) */
-        do {
-                stream.avail_in = fread(in, 1, ZLIB_BLOCK, two);
+        if (status != Z_OK) {
+                zlib_prefix_free(prefix);
+        }
 
-                if (ferror(two)) {
-                        deflateEnd(&stream);
-                        return Z_ERRNO;
-                }
+        return status;
+}
 
-                flush = feof(two) ? Z_FINISH : Z_NO_FLUSH;
-                stream.next_in = in;
 
-                /* 
-                 * Run deflate() on input until the output
-                 * buffer is no longer full. Terminate if
-                 * all of the source has been read.
-                 */
-                do {
-                        stream.avail_out = ZLIB_BLOCK;
-                        stream.next_out  = out;
+/**
+ * zlib_size_prefix()
+ * ``````````````````
+ * Find the compressed size of a prefix snapshot followed by a source buffer.
+ *
+ * @prefix : Prefix state (see zlib_prefix_init()), left unchanged
+ * @two    : Source buffer two (decompressed)
+ * @two_len: Length of @two in bytes
+ * @dst    : Target file (compressed), or NULL if not wanted. The 
+ *           prefix must have been made with @keep set to write one.
+ * Return  : Compressed size in bytes, or -1 on error.
+ *
+ * NOTE
+ * This is the same stream zlib_size_cat() would make from
+ * the prefix buffer and @two, but only @two is compressed here.
+ */
+long zlib_size_prefix(struct zlib_prefix_t *prefix, const void *two, size_t two_len, FILE *dst)
+{
+        z_stream stream;
+        size_t size;
 
-                        status = deflate(&stream, flush);
+        if (dst != NULL && prefix->out == NULL) {
+                return -1;
+        }
 
-                        /* State not clobbered */
-                        assert(status != Z_STREAM_ERROR);  
+        /* Copy the snapshot, which has seen all of 'one' */
+        if (deflateCopy(&stream, &prefix->stream) != Z_OK) {
+                return -1;
+        }
 
-                        have = ZLIB_BLOCK - stream.avail_out;
+        if (dst != NULL) {
+                if (fwrite(prefix->out, 1, prefix->out_len, dst) != prefix->out_len || ferror(dst)) {
+                        deflateEnd(&stream);
+                        return -1;
+                }
+        }
 
-                        if (fwrite(out, 1, have, dst) != have || ferror(dst)) {
-                                deflateEnd(&stream);
-                                return Z_ERRNO;
-                        }
+        size = prefix->out_len;
 
-                } while (stream.avail_out == 0);
+        if (zlib_deflate_mem(&stream, two, two_len, 1, dst, &size) != Z_OK) {
+                deflateEnd(&stream);
+                return -1;
+        }
 
-                /* All input should be used */
-                assert(stream.avail_in == 0);     
+        deflateEnd(&stream);
 
-        } while (flush != Z_FINISH);
+        return (long)size;
+}
 
-        assert(status == Z_STREAM_END);
 
-        /* Clean up */
+/**
+ * zlib_prefix_free()
+ * ``````````````````
+ * Release a prefix snapshot.
+ *
+ * @prefix: Prefix state (see zlib_prefix_init())
+ * Return : nothing
+ */
+void zlib_prefix_free(struct zlib_prefix_t *prefix)
+{
+        deflateEnd(&prefix->stream);
 
-        deflateEnd(&stream);
+        if (prefix->out != NULL) {
+                free(prefix->out);
+        }
 
-        return Z_OK;
+        prefix->out     = NULL;
+        prefix->out_len = 0;
+        prefix->out_max = 0;
 }
 
 
@@ -12,8 +12,24 @@
 #include <stdio.h>
 #include <zlib.h>
 
+/* 
+ * A stream that has compressed one buffer without flushing,
+ * and the output it emitted on the way. 
+ */
+struct zlib_prefix_t {
+        z_stream       stream;
+        unsigned char *out;       /* Output so far (if kept) */
+        size_t         out_len;   /* Length of the output so far */
+        size_t         out_max;
+};
+
 int  zlib_compress    (FILE *src, FILE *dst);
 int  zlib_compress_cat(FILE *one, FILE *two, FILE *dst);
+long zlib_size        (const void *src, size_t len, FILE *dst);
+long zlib_size_cat    (const void *one, size_t one_len, const void *two, size_t two_len, FILE *dst);
+int  zlib_prefix_init (struct zlib_prefix_t *prefix, const void *one, size_t one_len, int keep);
+long zlib_size_prefix (struct zlib_prefix_t *prefix, const void *two, size_t two_len, FILE *dst);
+void zlib_prefix_free (struct zlib_prefix_t *prefix);
 int  zlib_decompress  (FILE *src, FILE *dst);
 void zlib_strerror    (int status);
 
@@ -1,6 +1,9 @@
 #include <stdlib.h>
 #include <stdio.h>
+#include <string.h>
+#include <math.h>
 #include "ncd.h"
+#include "../common/matrix_file.h"
 
 
 struct ncd_t *ncd_create(int count)
@@ -10,12 +13,13 @@ struct ncd_t *ncd_create(int count)
 
         ncd = calloc(1, sizeof(struct ncd_t));
 
-        ncd->count = count;
+        ncd->count    = count;
+        ncd->symmetry = NCD_FULL;
         ncd->size_single = calloc(1, count * sizeof(int));
         ncd->size_double = calloc(1, count * sizeof(int *));
 
         for (i=0; i<count; i++) {
-                ncd->size_double[i] = calloc(1, sizeof(int));
+                ncd->size_double[i] = calloc(1, count * sizeof(int));
         }
 
         return ncd;
@@ -32,6 +36,126 @@ double ncd_compute(int size_a, int size_b, int size_ab)
 }
 
 
+/**
+ * ncd_wanted()
+ * ````````````
+ * Whether the pair @i,@j has to be compressed, for the symmetry in use.
+ */
+int ncd_wanted(struct ncd_t *ncd, int i, int j)
+{
+        switch (ncd->symmetry) {
+        case NCD_UPPER:
+                return i < j;
+        case NCD_AVERAGE:
+                return i != j;
+        default:
+                return 1;
+        }
+}
+
+
+/**
+ * ncd_pairs()
+ * ```````````
+ * The number of pairs ncd_wanted() accepts, for the symmetry in use.
+ */
+long ncd_pairs(struct ncd_t *ncd)
+{
+        long n = ncd->count;
+
+        switch (ncd->symmetry) {
+        case NCD_UPPER:
+                return n * (n - 1) / 2;
+        case NCD_AVERAGE:
+                return n * (n - 1);
+        default:
+                return n * n;
+        }
+}
+
+
+/**
+ * ncd_pair()
+ * ``````````
+ * The @k-th wanted pair, in row-major order, 0 <= @k < ncd_pairs().
+ *
+ * NOTE
+ * Worked out from @k, so that a run over many files needs no
+ * table of its pairs. Under NCD_UPPER, row i starts at pair
+ * i(2n-i-1)/2; the root of that gives the row, and the two
+ * loops make up for any rounding in the sqrt().
+ */
+void ncd_pair(struct ncd_t *ncd, long k, int *i, int *j)
+{
+        long n = ncd->count;
+        long r;
+
+        switch (ncd->symmetry) {
+        case NCD_UPPER:
+                r = (long)(((2*n - 1) - sqrt((double)(2*n - 1)*(2*n - 1) - 8.0*k)) / 2);
+
+                if (r < 0) {
+                        r = 0;
+                }
+                while (r > 0 && r*(2*n - r - 1)/2 > k) {
+                        r--;
+                }
+                while ((r+1)*(2*n - r - 2)/2 <= k) {
+                        r++;
+                }
+
+                *i = (int)r;
+                *j = (int)(k - r*(2*n - r - 1)/2 + r + 1);
+                break;
+        case NCD_AVERAGE:
+                *i = (int)(k / (n - 1));
+                *j = (int)(k % (n - 1));
+                *j += (*j >= *i);
+                break;
+        default:
+                *i = (int)(k / n);
+                *j = (int)(k % n);
+                break;
+        }
+}
+
+
+/**
+ * ncd_entry()
+ * ```````````
+ * The distance between files @i and @j.
+ *
+ * NOTE
+ * With any symmetry but NCD_FULL, the diagonal is set to 0,
+ * the distance from a file to itself, without compressing,
+ * and the matrix is made symmetric from the pairs that were.
+ */
+double ncd_entry(struct ncd_t *ncd, int i, int j)
+{
+        int *s = ncd->size_single;
+        int a;
+        int b;
+
+        if (ncd->symmetry == NCD_FULL) {
+                return ncd_compute(s[i], s[j], ncd->size_double[i][j]);
+        }
+
+        if (i == j) {
+                return 0.0;
+        }
+
+        a = (i < j) ? i : j;
+        b = (i < j) ? j : i;
+
+        if (ncd->symmetry == NCD_AVERAGE) {
+                return 0.5 * (ncd_compute(s[a], s[b], ncd->size_double[a][b])
+                            + ncd_compute(s[b], s[a], ncd->size_double[b][a]));
+        }
+
+        return ncd_compute(s[a], s[b], ncd->size_double[a][b]);
+}
+
+
 void ncd_test(struct ncd_t *ncd)
 {
         int i;
@@ -61,13 +185,7 @@ void ncd_print_2files(struct ncd_t *ncd, struct directory_t *dir)
         for (i=0; i<dir->file_count; i++) {
                 fprintf(dat, "\n");
                 for (j=0; j<dir->file_count; j++) {
-                        fprintf(dat, "%-20g ",
-                                ncd_compute(
-                                        ncd->size_single[i], 
-                                        ncd->size_single[j], 
-                                        ncd->size_double[i][j]
-                                )
-                        );
+                        fprintf(dat, "%-20g ", ncd_entry(ncd, i, j));
                 }
         }
 
@@ -75,6 +193,76 @@ void ncd_print_2files(struct ncd_t *ncd, struct directory_t *dir)
         fclose(dat);
 }
 
+/**
+ * ncd_print_binary()
+ * ``````````````````
+ * Write the matrix, and the file names as labels, in the binary 
+ * matrix format (see common/matrix_file.h), as float32.
+ *
+ * @ncd  : the sizes
+ * @dir  : the files they are for
+ * @path : the file to write
+ * Return: 0 on success, -1 if the file could not be written.
+ */
+int ncd_print_binary(struct ncd_t *ncd, struct directory_t *dir, const char *path)
+{
+        struct matrix_file_t head;
+        char   pad[MATRIX_FILE_ALIGN] = {0};
+        float *row;
+        FILE  *out;
+        int    n = dir->file_count;
+        int    i;
+        int    j;
+
+        memset(&head, 0, sizeof(head));
+        memcpy(head.magic, MATRIX_FILE_MAGIC, sizeof(head.magic));
+
+        head.n      = n;
+        head.elem   = MATRIX_FILE_F32;
+        head.labels = 0;
+
+        for (i=0; i<n; i++) {
+                head.labels += strlen(dir->file_name[i]) + 1;
+        }
+
+        head.data = sizeof(head) + head.labels;
+
+        if (head.data % MATRIX_FILE_ALIGN != 0) {
+                head.data += MATRIX_FILE_ALIGN - (head.data % MATRIX_FILE_ALIGN);
+        }
+
+        if ((out = fopen(path, "w")) == NULL) {
+                return -1;
+        }
+
+        fwrite(&head, sizeof(head), 1, out);
+
+        for (i=0; i<n; i++) {
+                fwrite(dir->file_name[i], 1, strlen(dir->file_name[i]) + 1, out);
+        }
+
+        fwrite(pad, 1, head.data - sizeof(head) - head.labels, out);
+
+        row = calloc(n, sizeof(float));
+
+        for (i=0; i<n; i++) {
+                for (j=0; j<n; j++) {
+                        row[j] = (float)ncd_entry(ncd, i, j);
+                }
+                fwrite(row, sizeof(float), n, out);
+        }
+
+        free(row);
+
+        if (ferror(out)) {
+                fclose(out);
+                return -1;
+        }
+
+        return fclose(out);
+}
+
+
 void ncd_print(struct ncd_t *ncd, struct directory_t *dir)
 {
         int i;
@@ -101,13 +289,7 @@ void ncd_print(struct ncd_t *ncd, struct directory_t *dir)
                                 printf("%-2d ", i);
                         }
 
-                        printf("%-20g ",
-                                ncd_compute(
-                                        ncd->size_single[i], 
-                                        ncd->size_single[j], 
-                                        ncd->size_double[i][j]
-                                )
-                        );
+                        printf("%-20g ", ncd_entry(ncd, i, j));
                 }
         }
 }
@@ -2,17 +2,28 @@
 #define __NCD_H
 #include "filesystem.h"
 
+/* Which pairs are compressed (see ncd_entry()) */
+#define NCD_FULL    0   /* Every ordered pair, diagonal included */
+#define NCD_UPPER   1   /* Only i<j, mirrored */
+#define NCD_AVERAGE 2   /* Both orders of i!=j, averaged */
+
 struct ncd_t {
         int count;
+        int symmetry;
         int *size_single;
         int **size_double;
 };
 
 struct ncd_t *ncd_create (int count);
+int           ncd_wanted (struct ncd_t *ncd, int i, int j);
+long          ncd_pairs  (struct ncd_t *ncd);
+void          ncd_pair   (struct ncd_t *ncd, long k, int *i, int *j);
+double        ncd_entry  (struct ncd_t *ncd, int i, int j);
 void          ncd_test   (struct ncd_t *ncd);
 void          ncd_print  (struct ncd_t *ncd, struct directory_t *dir);
 double        ncd_compute(int size_a, int size_b, int size_ab);
 void          ncd_print_2files(struct ncd_t *ncd, struct directory_t *dir);
+int           ncd_print_binary(struct ncd_t *ncd, struct directory_t *dir, const char *path);
 
 
 #endif
@@ -0,0 +1,86 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdatomic.h>
+#include <pthread.h>
+#include "schedule.h"
+
+struct schedule_t {
+        int         count;      /* Number of jobs */
+        atomic_int  next;       /* Next job to hand out */
+        schedule_cb work;       /* Runs one job */
+        void       *arg;        /* Passed to @work */
+};
+
+
+/**
+ * schedule_worker()
+ * `````````````````
+ * Take jobs from the queue and run them until there are none left.
+ *
+ * @arg  : Pointer to the shared struct schedule_t
+ * Return: NULL
+ */
+static void *schedule_worker(void *arg)
+{
+        struct schedule_t *s = arg;
+        int job;
+
+        while ((job = atomic_fetch_add(&s->next, 1)) < s->count) {
+                s->work(job, s->arg);
+        }
+
+        return NULL;
+}
+
+
+/**
+ * schedule_run()
+ * ``````````````
+ * Run jobs 0..@count-1 across a pool of worker threads.
+ *
+ * @count  : Number of jobs
+ * @workers: Number of worker threads (1 runs the jobs in order, here)
+ * @work   : Called as work(job, @arg) once for each job
+ * @arg    : Passed to @work
+ * Return  : nothing, once every job has finished
+ *
+ * NOTE
+ * Jobs are handed out one at a time as workers become free,
+ * so long and short jobs balance out. @work must only touch
+ * state that belongs to its own job.
+ */
+void schedule_run(int count, int workers, schedule_cb work, void *arg)
+{
+        struct schedule_t s;
+        pthread_t *thread;
+        int i;
+
+        s.count = count;
+        s.work  = work;
+        s.arg   = arg;
+        atomic_init(&s.next, 0);
+
+        if (workers > count) {
+                workers = count;
+        }
+
+        if (workers <= 1) {
+                schedule_worker(&s);
+                return;
+        }
+
+        thread = calloc(workers, sizeof(pthread_t));
+
+        for (i=0; i<workers; i++) {
+                if (pthread_create(&thread[i], NULL, schedule_worker, &s) != 0) {
+                        fprintf(stderr, "Could not start worker thread.\n");
+                        exit(1);
+                }
+        }
+
+        for (i=0; i<workers; i++) {
+                pthread_join(thread[i], NULL);
+        }
+
+        free(thread);
+}
@@ -0,0 +1,9 @@
+#ifndef __NCD_SCHEDULE
+#define __NCD_SCHEDULE
+
+/* Function pointer run once for each job number. */
+typedef void (*schedule_cb)(int job, void *arg);
+
+void schedule_run(int count, int workers, schedule_cb work, void *arg);
+
+#endif
@@ -0,0 +1,276 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <inttypes.h>
+#include "store.h"
+
+/******************************************************************************
+ * RESULTS STORE
+ *
+ * Compressed sizes depend only on the bytes compressed, so they are kept
+ * between runs, keyed by content hash, in a text file with one line per
+ * size:
+ *
+ *      s <hash> <size>                 C(x)
+ *      p <hash x> <hash y> <size>      C(xy)
+ *
+ * A rerun over a grown corpus then only compresses the new files and
+ * the pairs that involve them. New lines are appended on save.
+ ******************************************************************************/
+
+#define FNV_OFFSET 0xcbf29ce484222325ULL
+#define FNV_PRIME  0x100000001b3ULL
+
+#define STORE_INITIAL_SIZE 1024
+
+
+/**
+ * store_hash()
+ * ````````````
+ * Hash the contents of a buffer.
+ *
+ * @data : buffer
+ * @len  : length of @data in bytes
+ * Return: 64-bit FNV-1a hash of @len and the bytes of @data.
+ */
+uint64_t store_hash(const void *data, size_t len)
+{
+        const unsigned char *byte;
+        uint64_t h = FNV_OFFSET;
+        size_t   k;
+
+        byte = (const unsigned char *)&len;
+
+        for (k=0; k<sizeof(size_t); k++) {
+                h = (h ^ byte[k]) * FNV_PRIME;
+        }
+
+        byte = (const unsigned char *)data;
+
+        for (k=0; k<len; k++) {
+                h = (h ^ byte[k]) * FNV_PRIME;
+        }
+
+        return h;
+}
+
+
+/**
+ * store_find()
+ * ````````````
+ * Find the slot holding a key, or the empty slot where it would go.
+ */
+static struct store_entry_t *store_find(struct store_t *store, char kind, uint64_t a, uint64_t b)
+{
+        struct store_entry_t *e;
+        size_t k;
+
+        k = (size_t)((a ^ (b * FNV_PRIME) ^ (uint64_t)kind) * FNV_PRIME);
+
+        for (;; k++) {
+                e = &store->slot[k & (store->max - 1)];
+
+                if (e->kind == 0 || (e->kind == kind && e->a == a && e->b == b)) {
+                        return e;
+                }
+        }
+}
+
+
+/**
+ * store_put()
+ * ```````````
+ * Set the size for a key, growing the table to stay at most half full.
+ */
+static void store_put(struct store_t *store, char kind, uint64_t a, uint64_t b, long size, char fresh)
+{
+        struct store_entry_t *old;
+        struct store_entry_t *e;
+        size_t old_max;
+        size_t k;
+
+        if (2 * (store->count + 1) > store->max) {
+                old     = store->slot;
+                old_max = store->max;
+
+                store->max  *= 2;
+                store->slot  = calloc(store->max, sizeof(struct store_entry_t));
+
+                for (k=0; k<old_max; k++) {
+                        if (old[k].kind != 0) {
+                                *store_find(store, old[k].kind, old[k].a, old[k].b) = old[k];
+                        }
+                }
+
+                free(old);
+        }
+
+        e = store_find(store, kind, a, b);
+
+        if (e->kind == 0) {
+                e->kind  = kind;
+                e->a     = a;
+                e->b     = b;
+                e->fresh = fresh;
+                store->count++;
+        } else if (e->size != size) {
+                e->fresh = fresh;
+        }
+
+        e->size = size;
+}
+
+
+/**
+ * store_load()
+ * ````````````
+ * Read a store from its file.
+ *
+ * @path : path of the store file
+ * Return: Pointer to a store; empty if the file does not exist yet.
+ *
+ * NOTE
+ * If a key appears more than once, the last line wins.
+ */
+struct store_t *store_load(const char *path)
+{
+        struct store_t *store;
+        char     line[256];
+        uint64_t a;
+        uint64_t b;
+        long     size;
+        FILE    *f;
+
+        store = calloc(1, sizeof(struct store_t));
+
+        store->max   = STORE_INITIAL_SIZE;
+        store->slot  = calloc(store->max, sizeof(struct store_entry_t));
+        store->count = 0;
+
+        if ((f = fopen(path, "r")) == NULL) {
+                return store;
+        }
+
+        while (fgets(line, sizeof(line), f) != NULL) {
+                if (sscanf(line, "p %" SCNx64 " %" SCNx64 " %ld", &a, &b, &size) == 3) {
+                        store_put(store, 'p', a, b, size, 0);
+                } else if (sscanf(line, "s %" SCNx64 " %ld", &a, &size) == 2) {
+                        store_put(store, 's', a, 0, size, 0);
+                }
+        }
+
+        fclose(f);
+
+        return store;
+}
+
+
+/**
+ * store_save()
+ * ````````````
+ * Append the sizes added since the store was loaded to its file.
+ *
+ * @store: store
+ * @path : path of the store file
+ * Return: 0 on success, -1 if the file could not be written.
+ */
+int store_save(struct store_t *store, const char *path)
+{
+        struct store_entry_t *e;
+        size_t k;
+        FILE *f;
+
+        if ((f = fopen(path, "a")) == NULL) {
+                return -1;
+        }
+
+        for (k=0; k<store->max; k++) {
+                e = &store->slot[k];
+
+                if (e->kind == 0 || !e->fresh) {
+                        continue;
+                }
+
+                if (e->kind == 's') {
+                        fprintf(f, "s %016" PRIx64 " %ld\n", e->a, e->size);
+                } else {
+                        fprintf(f, "p %016" PRIx64 " %016" PRIx64 " %ld\n", e->a, e->b, e->size);
+                }
+
+                e->fresh = 0;
+        }
+
+        fclose(f);
+
+        return 0;
+}
+
+
+/**
+ * store_free()
+ * ````````````
+ * Free a store.
+ */
+void store_free(struct store_t *store)
+{
+        if (store != NULL) {
+                free(store->slot);
+                free(store);
+        }
+}
+
+
+/**
+ * store_get_single()
+ * ``````````````````
+ * Look up C(x) by the hash of x.
+ *
+ * Return: the size, or -1 if it is not in the store.
+ */
+long store_get_single(struct store_t *store, uint64_t a)
+{
+        struct store_entry_t *e = store_find(store, 's', a, 0);
+
+        return (e->kind == 0) ? -1 : e->size;
+}
+
+
+/**
+ * store_get_pair()
+ * ````````````````
+ * Look up C(xy) by the hashes of x and y.
+ *
+ * Return: the size, or -1 if it is not in the store.
+ */
+long store_get_pair(struct store_t *store, uint64_t a, uint64_t b)
+{
+        struct store_entry_t *e = store_find(store, 'p', a, b);
+
+        return (e->kind == 0) ? -1 : e->size;
+}
+
+
+/**
+ * store_put_single()
+ * ``````````````````
+ * Record C(x) under the hash of x.
+ *
+ * NOTE
+ * Lookups only read the table, so any number of threads may
+ * make them at once, but puts must not run alongside them.
+ */
+void store_put_single(struct store_t *store, uint64_t a, long size)
+{
+        store_put(store, 's', a, 0, size, 1);
+}
+
+
+/**
+ * store_put_pair()
+ * ````````````````
+ * Record C(xy) under the hashes of x and y (see store_put_single()).
+ */
+void store_put_pair(struct store_t *store, uint64_t a, uint64_t b, long size)
+{
+        store_put(store, 'p', a, b, size, 1);
+}
@@ -0,0 +1,32 @@
+#ifndef __NCD_STORE
+#define __NCD_STORE
+#include <stdint.h>
+#include <stddef.h>
+
+/*
+ * A compressed size, keyed by the content hash of its input(s).
+ */
+struct store_entry_t {
+        uint64_t a;             /* Hash of the (first) input */
+        uint64_t b;             /* Hash of the second input, for a pair */
+        long     size;          /* Compressed size */
+        char     kind;          /* 0 (empty slot), 's' or 'p' */
+        char     fresh;         /* Not yet saved */
+};
+
+struct store_t {
+        struct store_entry_t *slot;
+        size_t                max;      /* Always a power of 2 */
+        size_t                count;
+};
+
+uint64_t        store_hash       (const void *data, size_t len);
+struct store_t *store_load       (const char *path);
+int             store_save       (struct store_t *store, const char *path);
+void            store_free       (struct store_t *store);
+long            store_get_single (struct store_t *store, uint64_t a);
+long            store_get_pair   (struct store_t *store, uint64_t a, uint64_t b);
+void            store_put_single (struct store_t *store, uint64_t a, long size);
+void            store_put_pair   (struct store_t *store, uint64_t a, uint64_t b, long size);
+
+#endif